@@ -0,0 +1,65 @@
+#include "activity.hpp"
+#include <algorithm>
+#include <cmath>
+
+void Activity::beginStep(int width, int height, size_t particleCount) {
+    if (idleTicks.size() != particleCount) idleTicks.assign(particleCount, 0);
+    int newCols = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+    int newRows = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+    if (newCols != cols || newRows != rows) {
+        cols = newCols;
+        rows = newRows;
+        woken.assign(size_t(cols) * rows, 0);
+        changed.assign(size_t(cols) * rows, 0);
+    }
+    std::fill(changed.begin(), changed.end(), 0);
+}
+
+void Activity::endStep() {
+    woken.swap(changed);
+}
+
+int Activity::cellOf(float x, float y) const {
+    int cx = std::clamp(static_cast<int>(x / cellSize), 0, cols - 1);
+    int cy = std::clamp(static_cast<int>(y / cellSize), 0, rows - 1);
+    return cy * cols + cx;
+}
+
+bool Activity::neighborhoodChanged(float x, float y) const {
+    int cell = cellOf(x, y);
+    int cx = cell % cols;
+    int cy = cell / cols;
+    // Соседи по тору
+    for (int dy = -1; dy <= 1; ++dy) {
+        int ny = (cy + dy + rows) % rows;
+        for (int dx = -1; dx <= 1; ++dx) {
+            int nx = (cx + dx + cols) % cols;
+            if (woken[ny * cols + nx]) return true;
+        }
+    }
+    return false;
+}
+
+void Activity::markChanged(float x, float y) {
+    changed[cellOf(x, y)] = 1;
+}
+
+void Activity::touch(size_t i, const Particle& p, float oldX, float oldY) {
+    idleTicks[i] = 0;
+    markChanged(oldX, oldY);
+    markChanged(p.x, p.y);
+}
+
+void Activity::afterIntegration(size_t i, const Particle& p, float oldX, float oldY, float dvx, float dvy) {
+    bool quiet = dvx * dvx + dvy * dvy < accelThreshold * accelThreshold
+                 && p.vx * p.vx + p.vy * p.vy < speedThreshold * speedThreshold;
+    int& ticks = idleTicks[i];
+    if (!quiet) ticks = 0;
+    else if (ticks < idleSteps) ticks++;
+
+    // Активная частица или переход в другую ячейку — повод разбудить соседей
+    if (ticks == 0 || cellOf(oldX, oldY) != cellOf(p.x, p.y)) {
+        markChanged(oldX, oldY);
+        markChanged(p.x, p.y);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "particle.hpp"
+
+// Усыпление неподвижных частиц. Частица, у которой скорость и приращение скорости
+// idleSteps шагов подряд ниже порогов, считается спящей: simulate() не считает для неё
+// силы и не двигает её. Спящая частица просыпается, когда её касается случайное событие
+// или когда на прошлом шаге что-то изменилось в её ячейке сетки или в соседних
+// (туда вошла/оттуда ушла частица, там двигалась активная частица или произошло событие).
+// Счётчики неподвижности хранятся здесь, а не в Particle, — по индексу частицы в векторе;
+// simulate() сдвигает их вместе с частицами при удалении и добавлении.
+struct Activity {
+    bool enabled = false;
+    // Пороги по умолчанию подобраны на встроенных матрицах: частицы никогда не замирают полностью
+    // (у пресета 1 в установившемся режиме медиана скорости ~0.15), поэтому заметная часть засыпает
+    // только в "Охоте"; в пресетах 2-4 частицы почти всё время бодрствуют
+    float speedThreshold = 0.3f;   // порог скорости (--sleep-speed)
+    float accelThreshold = 0.03f;  // порог изменения скорости за шаг (--sleep-accel)
+    int idleSteps = 5;             // сколько шагов подряд ниже порогов до засыпания (--sleep-steps)
+    float cellSize = 4.0f;         // размер ячейки сетки изменений
+
+    int cols = 0;
+    int rows = 0;
+    std::vector<uint8_t> woken;   // ячейки, изменившиеся на прошлом шаге
+    std::vector<uint8_t> changed; // ячейки, изменившиеся на текущем шаге
+    std::vector<int> idleTicks;   // сколько шагов подряд частица i почти неподвижна
+
+    // Подготовка сетки к шагу. Если число частиц не совпадает со счётчиками, вектор частиц
+    // заменили — все счётчики начинаются заново
+    void beginStep(int width, int height, size_t particleCount);
+    void endStep();                        // изменения шага становятся поводом для пробуждения на следующем
+    void reset() { idleTicks.clear(); }    // частицы заменены целиком (новое состояние)
+
+    bool isDormant(size_t i) const { return enabled && idleTicks[i] >= idleSteps; }
+    bool neighborhoodChanged(float x, float y) const; // изменилась ли ячейка точки или соседняя на прошлом шаге
+    void markChanged(float x, float y);
+    void touch(size_t i, const Particle& p, float oldX, float oldY); // частицу затронуло событие: разбудить и отметить ячейки
+    void putToSleep(size_t i) { idleTicks[i] = idleSteps; }
+    void erase(size_t i) { idleTicks.erase(idleTicks.begin() + i); } // частица i удалена
+    void add() { idleTicks.push_back(0); }                              // в конец добавлена новая частица
+    // Учёт шага интегрирования: dvx, dvy — приращение скорости от сил
+    void afterIntegration(size_t i, const Particle& p, float oldX, float oldY, float dvx, float dvy);
+
+private:
+    int cellOf(float x, float y) const;
+};
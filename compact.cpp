@@ -0,0 +1,211 @@
+#include "compact.hpp"
+#include "simulation.hpp"
+#include "physics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// --- half float (binary16) без зависимости от аппаратной поддержки ---
+
+static uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude >= 0x477FF000) return sign | 0x7BFF; // за пределами half (и inf/nan) — максимальное конечное
+    if (magnitude <= 0x33000000) return sign;           // меньше половины наименьшего денормала — ноль
+
+    uint32_t exponent = magnitude >> 23;
+    uint32_t half, rest, halfway;
+    if (exponent < 113) {
+        // Денормализованное half: мантисса с неявной единицей, сдвинутая по экспоненте
+        uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+        uint32_t shift = 126 - exponent;
+        half = mantissa >> shift;
+        rest = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    } else {
+        half = ((exponent - 112) << 10) | ((magnitude >> 13) & 0x3FF);
+        rest = magnitude & 0x1FFF;
+        halfway = 0x1000;
+    }
+    // Округление к ближайшему чётному; перенос в экспоненту получается сам
+    if (rest > halfway || (rest == halfway && (half & 1))) half++;
+    return static_cast<uint16_t>(sign | half);
+}
+
+static float halfToFloat(uint16_t half) {
+    uint32_t sign = uint32_t(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    if (exponent == 0) {
+        float v = mantissa * 5.9604645e-8f; // 2^-24
+        return sign ? -v : v;
+    }
+    uint32_t bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Координата в 24-битную долю размера поля; всё, что за краем, заворачивается по тору
+static uint32_t encodeCoord(float v, int size) {
+    long long q = std::llround(double(v) * 16777216.0 / size);
+    return static_cast<uint32_t>(q & 0xFFFFFF);
+}
+
+static uint8_t encodeState(int type, int highlightTicks) {
+    return static_cast<uint8_t>((type & 0x0F) | (std::clamp(highlightTicks, 0, 15) << 4));
+}
+
+size_t CompactParticles::bytesPerParticle() const {
+    return sizeof(uint16_t) * 4 + sizeof(uint8_t) * 3 + sizeof(uint32_t);
+}
+
+void CompactParticles::assign(size_t count, int fieldWidth, int fieldHeight, float minMass, float maxMass) {
+    width = fieldWidth;
+    height = fieldHeight;
+    // Массы событий (1..1.5) тоже должны помещаться
+    massMin = std::min(1.0f, minMass);
+    massMax = std::max(1.5f, maxMass);
+    x.assign(count, 0); y.assign(count, 0);
+    xFine.assign(count, 0); yFine.assign(count, 0);
+    vx.assign(count, 0); vy.assign(count, 0);
+    mass.assign(count, 0);
+    idState.assign(count, 0);
+}
+
+void CompactParticles::encode(const std::vector<Particle>& particles, int fieldWidth, int fieldHeight) {
+    float minMass = 1.0f, maxMass = 1.5f;
+    for (const auto& p : particles) {
+        minMass = std::min(minMass, p.mass);
+        maxMass = std::max(maxMass, p.mass);
+    }
+    assign(particles.size(), fieldWidth, fieldHeight, minMass, maxMass);
+    for (size_t i = 0; i < particles.size(); ++i) set(i, particles[i]);
+}
+
+void CompactParticles::decode(std::vector<Particle>& particles) const {
+    particles.resize(size());
+    for (size_t i = 0; i < size(); ++i) particles[i] = get(i);
+}
+
+Particle CompactParticles::get(size_t i) const {
+    Particle p;
+    p.x = decodeX(i);
+    p.y = decodeY(i);
+    p.vx = halfToFloat(vx[i]);
+    p.vy = halfToFloat(vy[i]);
+    p.type = decodeType(i);
+    p.mass = decodeMass(i);
+    p.highlightTicks = (idState[i] >> 4) & 0x0F;
+    p.id = decodeId(i);
+    return p;
+}
+
+void CompactParticles::set(size_t i, const Particle& p) {
+    uint32_t qx = encodeCoord(p.x, width);
+    uint32_t qy = encodeCoord(p.y, height);
+    x[i] = static_cast<uint16_t>(qx >> 8);
+    xFine[i] = static_cast<uint8_t>(qx & 0xFF);
+    y[i] = static_cast<uint16_t>(qy >> 8);
+    yFine[i] = static_cast<uint8_t>(qy & 0xFF);
+    vx[i] = floatToHalf(p.vx);
+    vy[i] = floatToHalf(p.vy);
+    long q = std::lround(double(p.mass - massMin) * 255.0 / (massMax - massMin));
+    mass[i] = static_cast<uint8_t>(std::clamp(q, 0L, 255L));
+    idState[i] = (uint32_t(p.id) << 8) | encodeState(p.type, p.highlightTicks);
+}
+
+void CompactParticles::push(const Particle& p) {
+    x.push_back(0); y.push_back(0); xFine.push_back(0); yFine.push_back(0);
+    vx.push_back(0); vy.push_back(0); mass.push_back(0); idState.push_back(0);
+    set(size() - 1, p);
+}
+
+void CompactParticles::erase(size_t i) {
+    x.erase(x.begin() + i);
+    y.erase(y.begin() + i);
+    xFine.erase(xFine.begin() + i);
+    yFine.erase(yFine.begin() + i);
+    vx.erase(vx.begin() + i);
+    vy.erase(vy.begin() + i);
+    mass.erase(mass.begin() + i);
+    idState.erase(idState.begin() + i);
+}
+
+void recount_compact(const CompactParticles& particles, Statistics& stats) {
+    stats.beginRecount();
+    for (size_t i = 0; i < particles.size(); ++i) stats.recountParticle(particles.get(i));
+    stats.endRecount();
+}
+
+void simulate_compact(CompactParticles& particles, bool enableRandomEvents, Statistics& stats,
+                      const InteractionMatrix& matrix, std::mt19937& rng) {
+    const int width = particles.width;
+    const int height = particles.height;
+    const float scaleX = width / 16777216.0f;
+    const float scaleY = height / 16777216.0f;
+    const float massMin = particles.massMin;
+    const float scaleMass = (particles.massMax - particles.massMin) / 255.0f;
+
+    stats.beginKinematics();
+
+    for (size_t i = 0; i < particles.size(); ++i) {
+        Particle p = particles.get(i);
+
+        // Случайные события — общие с simulate()
+        if (enableRandomEvents) {
+            Particle child;
+            int eventType = random_event(p, child, width, height, stats, rng);
+            if (eventType == 0) {
+                particles.erase(i);
+                --i;
+                continue;
+            }
+            if (eventType == 2) {
+                child.id = static_cast<int>(particles.size());
+                if (child.id <= CompactParticles::MAX_ID) {
+                    stats.addParticle(child);
+                    particles.push(child);
+                } else {
+                    stats.reproductions--; // id потомка не помещается в 24 бита
+                }
+            }
+        }
+
+        // Остальные частицы распаковываются прямо во внутреннем цикле
+        const uint16_t* xs = particles.x.data();
+        const uint16_t* ys = particles.y.data();
+        const uint8_t* xsFine = particles.xFine.data();
+        const uint8_t* ysFine = particles.yFine.data();
+        const uint8_t* masses = particles.mass.data();
+        const uint32_t* idStates = particles.idState.data();
+        const size_t count = particles.size();
+        const auto& forces = matrix[p.type];
+
+        float ax = 0.0f;
+        float ay = 0.0f;
+        for (size_t j = 0; j < count; ++j) {
+            if (j == i) continue;
+
+            accumulatePair(((uint32_t(xs[j]) << 8) | xsFine[j]) * scaleX - p.x,
+                           ((uint32_t(ys[j]) << 8) | ysFine[j]) * scaleY - p.y,
+                           width, height, forces[idStates[j] & 0x0F], massMin + masses[j] * scaleMass,
+                           0.0f, ax, ay);
+        }
+
+        integrateParticle(p, ax, ay);
+
+        if (p.highlightTicks > 0)
+            p.highlightTicks--;
+
+        // Заворачивание по краям делает упаковка координат
+        particles.set(i, p);
+        stats.addKinematics(particles.get(i));
+    }
+
+    stats.endKinematics();
+    stats.dormantParticles = 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "config.hpp"
+#include "particle.hpp"
+#include "statistics.hpp"
+
+// Компактное хранение частиц для прогонов, упирающихся в память: структура массивов
+// из квантованных полей, 15 байт на частицу вместо sizeof(Particle) = 32.
+//   x, y     — 24-битная фиксированная точка в долях ширины/высоты поля: старшие 16 бит
+//              в x/y, младшие 8 — в xFine/yFine. Шаг поля 4000 — 0.00024 (как у float на
+//              такой координате), поэтому медленные частицы не "замерзают" на месте;
+//   vx, vy   — half float (IEEE 754 binary16): малые скорости не теряются при затухании;
+//   mass     — 8 бит на отрезке [massMin, massMax] (он включает массы событий 1..1.5);
+//   idState  — id (старшие 24 бита, не больше MAX_ID), тип (4 бита) и highlightTicks (4 бита).
+// Силы считаются во float после распаковки, поэтому результат близок к simulate(), но не совпадает побитно.
+struct CompactParticles {
+    static constexpr int MAX_ID = (1 << 24) - 1;
+
+    int width = 1;   // размер поля, к которому привязаны координаты
+    int height = 1;
+    float massMin = 1.0f; // отрезок квантования массы
+    float massMax = 1.5f;
+
+    std::vector<uint16_t> x, y;
+    std::vector<uint8_t> xFine, yFine;
+    std::vector<uint16_t> vx, vy;
+    std::vector<uint8_t> mass;
+    std::vector<uint32_t> idState;
+
+    size_t size() const { return idState.size(); }
+    size_t bytesPerParticle() const;
+
+    // count нулевых частиц для поля fieldWidth x fieldHeight и масс из [minMass, maxMass] (заменяет содержимое)
+    void assign(size_t count, int fieldWidth, int fieldHeight, float minMass, float maxMass);
+    void encode(const std::vector<Particle>& particles, int fieldWidth, int fieldHeight); // упаковать (заменяет содержимое)
+    void decode(std::vector<Particle>& particles) const; // распаковать
+
+    Particle get(size_t i) const;
+    void set(size_t i, const Particle& p); // id частицы должен быть не больше MAX_ID
+    void push(const Particle& p);
+    void erase(size_t i);
+
+    float decodeX(size_t i) const { return ((uint32_t(x[i]) << 8) | xFine[i]) * (width / 16777216.0f); }
+    float decodeY(size_t i) const { return ((uint32_t(y[i]) << 8) | yFine[i]) * (height / 16777216.0f); }
+    float decodeMass(size_t i) const { return massMin + mass[i] * ((massMax - massMin) / 255.0f); }
+    int decodeType(size_t i) const { return idState[i] & 0x0F; }
+    int decodeId(size_t i) const { return static_cast<int>(idState[i] >> 8); }
+};
+
+static_assert(TYPE_COUNT <= 16, "тип частицы хранится в 4 битах");
+
+// Шаг simulate() на компактном хранилище: те же силы, трение, тор и случайные события
+// (с тем же rng), но частицы распаковываются во float на лету и упаковываются обратно.
+// Спящие частицы (Activity) не поддерживаются. Потомок, id которого не помещается в MAX_ID,
+// не создаётся (событие размножения не засчитывается)
+void simulate_compact(CompactParticles& particles, bool enableRandomEvents, Statistics& stats,
+                      const InteractionMatrix& matrix, std::mt19937& rng);
+// Пересчёт агрегатов stats по типам без распаковки всего хранилища
+void recount_compact(const CompactParticles& particles, Statistics& stats);
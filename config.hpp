@@ -3,6 +3,9 @@
 
 constexpr int TYPE_COUNT = 3;
 
+// Матрица взаимодействий: [тип частицы][тип соседа] -> сила
+using InteractionMatrix = std::array<std::array<float, TYPE_COUNT>, TYPE_COUNT>;
+
 constexpr std::array<std::array<float, TYPE_COUNT>, TYPE_COUNT> getInteractionMatrix(int mode) {
     if (mode == 1) { // Охота
         return {{
@@ -0,0 +1,283 @@
+#include "domain.hpp"
+#include "physics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Запас ширины гало на округление границ полос
+static const float HALO_MARGIN = 0.01f;
+
+// Номера независимых случайных величин одного события
+enum EventDraw { DRAW_CHANCE, DRAW_TYPE, DRAW_VALUE, DRAW_VALUE2, DRAW_MASS };
+
+// splitmix64 — перемешивание 64-битного значения
+static uint64_t mix64(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Случайное число в [0, 1), зависящее только от (seed, шаг, id, номер величины)
+static float eventRandom(uint64_t seed, uint64_t step, int id, int draw) {
+    uint64_t h = mix64(seed ^ mix64(step ^ mix64((uint64_t(uint32_t(id)) << 8) | uint64_t(draw))));
+    return float(h >> 40) * (1.0f / 16777216.0f);
+}
+
+int slabOf(float x, int width, int slabs) {
+    int s = static_cast<int>(x * slabs / width);
+    return std::clamp(s, 0, slabs - 1);
+}
+
+bool inHalo(float x, int slab, int width, int slabs, float cutoff) {
+    if (cutoff <= 0.0f) return true;
+    if (slabOf(x, width, slabs) == slab) return true;
+    float x0 = float(slab) * width / slabs;
+    float x1 = float(slab + 1) * width / slabs;
+    // Расстояние по тору от частицы до ближайшего края полосы (с запасом на округление границ)
+    float ahead = std::fmod(x0 - x + width, float(width));
+    float behind = std::fmod(x - x1 + width, float(width));
+    return std::min(ahead, behind) <= cutoff + HALO_MARGIN;
+}
+
+void applyDomainEvents(std::vector<Particle>& owned, const DomainConfig& config, uint64_t step,
+                       int width, int height, std::vector<DomainEvent>& events, std::vector<Particle>& children) {
+    if (!config.enableRandomEvents) return;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < owned.size(); ++i) {
+        Particle p = owned[i];
+        const uint64_t seed = config.seed;
+
+        if (eventRandom(seed, step, p.id, DRAW_CHANCE) < EVENT_CHANCE) {
+            int eventType = std::min(6, static_cast<int>(eventRandom(seed, step, p.id, DRAW_TYPE) * 7));
+            events.push_back({p.id, eventType});
+
+            switch (eventType) {
+                case 0:
+                    continue; // частица удалена
+                case 1:
+                    p.type = std::min(TYPE_COUNT - 1, static_cast<int>(eventRandom(seed, step, p.id, DRAW_VALUE) * TYPE_COUNT));
+                    p.highlightTicks = 5;
+                    break;
+                case 2: {
+                    Particle child = p;
+                    child.x += eventRandom(seed, step, p.id, DRAW_VALUE) * 2.0f - 1.0f;
+                    child.y += eventRandom(seed, step, p.id, DRAW_VALUE2) * 2.0f - 1.0f;
+                    // Потомок сразу возвращается на тор, чтобы принадлежать ровно одной полосе
+                    if (child.x < 0) child.x += width;
+                    if (child.x >= width) child.x -= width;
+                    if (child.y < 0) child.y += height;
+                    if (child.y >= height) child.y -= height;
+                    child.mass = 1.0f + 0.5f * eventRandom(seed, step, p.id, DRAW_MASS);
+                    child.vx = 0.0f;
+                    child.vy = 0.0f;
+                    child.highlightTicks = 5;
+                    children.push_back(child); // id пока равен id родителя
+                    p.highlightTicks = 5;
+                    break;
+                }
+                case 3:
+                    p.x = eventRandom(seed, step, p.id, DRAW_VALUE) * width;
+                    p.y = eventRandom(seed, step, p.id, DRAW_VALUE2) * height;
+                    p.highlightTicks = 5;
+                    break;
+                case 4:
+                    p.mass = 1.0f + 0.5f * eventRandom(seed, step, p.id, DRAW_MASS);
+                    p.highlightTicks = 5;
+                    break;
+                case 5:
+                    p.vx = (eventRandom(seed, step, p.id, DRAW_VALUE) * 2.0f - 1.0f) * 2.0f;
+                    p.vy = (eventRandom(seed, step, p.id, DRAW_VALUE2) * 2.0f - 1.0f) * 2.0f;
+                    p.highlightTicks = 5;
+                    break;
+                case 6:
+                    p.vx = 0.0f;
+                    p.vy = 0.0f;
+                    p.highlightTicks = 5;
+                    break;
+            }
+        }
+        owned[kept++] = p;
+    }
+    owned.resize(kept);
+}
+
+void assignChildIds(std::vector<Particle>& children, const std::vector<int>& parentIds, int nextId) {
+    for (auto& child : children) {
+        auto it = std::lower_bound(parentIds.begin(), parentIds.end(), child.id);
+        child.id = nextId + static_cast<int>(it - parentIds.begin());
+    }
+}
+
+void integrateSlab(std::vector<Particle>& owned, const std::vector<Particle>& neighborhood,
+                   const DomainConfig& config, int width, int height) {
+    const float cutoffSq = config.cutoff > 0.0f ? config.cutoff * config.cutoff : 0.0f;
+
+    for (auto& p : owned) {
+        float ax = 0.0f;
+        float ay = 0.0f;
+        for (const auto& other : neighborhood) {
+            if (other.id == p.id) continue;
+            accumulatePair(other.x - p.x, other.y - p.y, width, height, config.matrix[p.type][other.type],
+                           other.mass, cutoffSq, ax, ay);
+        }
+
+        integrateParticle(p, ax, ay);
+        wrapToTorus(p, width, height);
+
+        if (p.highlightTicks > 0)
+            p.highlightTicks--;
+    }
+}
+
+void recordDomainEvents(Statistics& stats, std::vector<DomainEvent>& events) {
+    std::sort(events.begin(), events.end(), [](const DomainEvent& a, const DomainEvent& b) { return a.id < b.id; });
+    for (const auto& e : events) {
+        stats.totalRandomEvents++;
+        stats.recordRandomEvent(e.id);
+        stats.incrementEventCount(e.type);
+    }
+}
+
+void createSlabParticles(std::vector<Particle>& owned, int count, int width, int height,
+                         uint64_t seed, int slab, int slabs) {
+    // Начальное состояние — "шаг" с номером, которого не бывает у событий
+    const uint64_t INIT_STEP = ~0ull;
+    owned.clear();
+    for (int id = 0; id < count; ++id) {
+        float x = eventRandom(seed, INIT_STEP, id, DRAW_VALUE) * width;
+        if (x >= width) x -= width; // округление float у широкого поля
+        if (slabOf(x, width, slabs) != slab) continue;
+
+        Particle p;
+        p.x = x;
+        p.y = eventRandom(seed, INIT_STEP, id, DRAW_VALUE2) * height;
+        if (p.y >= height) p.y -= height;
+        p.vx = 0.0f;
+        p.vy = 0.0f;
+        p.type = std::min(TYPE_COUNT - 1, static_cast<int>(eventRandom(seed, INIT_STEP, id, DRAW_TYPE) * TYPE_COUNT));
+        p.mass = 1.0f + 0.5f * eventRandom(seed, INIT_STEP, id, DRAW_MASS);
+        p.highlightTicks = 0;
+        p.id = id;
+        owned.push_back(p);
+    }
+}
+
+static bool byId(const Particle& a, const Particle& b) {
+    return a.id < b.id;
+}
+
+// Запускает fn(slab) для всех полос, распределяя их по потокам
+template <typename Fn>
+static void forEachSlab(int slabCount, int threadCount, Fn fn) {
+    threadCount = std::clamp(threadCount, 1, slabCount);
+    if (threadCount == 1) {
+        for (int s = 0; s < slabCount; ++s) fn(s);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (int t = 0; t < threadCount; ++t) {
+        workers.emplace_back([=, &fn] {
+            for (int s = t; s < slabCount; s += threadCount) fn(s);
+        });
+    }
+    for (auto& w : workers) w.join();
+}
+
+DomainSim::DomainSim(int w, int h, const DomainConfig& cfg)
+    : width(w), height(h), config(cfg), slabs(std::max(1, cfg.slabs)) {
+    config.slabs = static_cast<int>(slabs.size());
+}
+
+void DomainSim::scatter(const std::vector<Particle>& particles) {
+    for (auto& s : slabs) s.clear();
+    steps = 0;
+    nextId = 0;
+    for (const auto& p : particles) {
+        slabs[slabOf(p.x, width, config.slabs)].push_back(p);
+        nextId = std::max(nextId, p.id + 1);
+    }
+}
+
+void DomainSim::populate(int count) {
+    steps = 0;
+    nextId = count;
+    forEachSlab(config.slabs, config.threads, [&](int s) {
+        createSlabParticles(slabs[s], count, width, height, config.seed, s, config.slabs);
+    });
+}
+
+void DomainSim::step(Statistics& stats) {
+    const int slabCount = config.slabs;
+
+    // 1. Случайные события — каждая полоса со своими частицами
+    std::vector<std::vector<DomainEvent>> events(slabCount);
+    std::vector<std::vector<Particle>> children(slabCount);
+    forEachSlab(slabCount, config.threads, [&](int s) {
+        applyDomainEvents(slabs[s], config, steps, width, height, events[s], children[s]);
+    });
+
+    std::vector<int> parentIds;
+    std::vector<DomainEvent> allEvents;
+    for (int s = 0; s < slabCount; ++s) {
+        for (const auto& c : children[s]) parentIds.push_back(c.id);
+        allEvents.insert(allEvents.end(), events[s].begin(), events[s].end());
+    }
+    std::sort(parentIds.begin(), parentIds.end());
+    for (int s = 0; s < slabCount; ++s) {
+        assignChildIds(children[s], parentIds, nextId);
+        slabs[s].insert(slabs[s].end(), children[s].begin(), children[s].end());
+    }
+    nextId += static_cast<int>(parentIds.size());
+    recordDomainEvents(stats, allEvents);
+
+    // 2. Миграция частиц, покинувших свою полосу (после прошлого шага, телепортации, потомки)
+    std::vector<Particle> migrants;
+    for (int s = 0; s < slabCount; ++s) {
+        auto& owned = slabs[s];
+        size_t kept = 0;
+        for (size_t i = 0; i < owned.size(); ++i) {
+            if (slabOf(owned[i].x, width, slabCount) == s) owned[kept++] = owned[i];
+            else migrants.push_back(owned[i]);
+        }
+        owned.resize(kept);
+    }
+    for (const auto& p : migrants)
+        slabs[slabOf(p.x, width, slabCount)].push_back(p);
+
+    // 3. Обмен гало: общий снимок состояния, из которого каждая полоса берёт свою окрестность
+    std::vector<Particle> snapshot;
+    snapshot.reserve(size());
+    for (const auto& s : slabs) snapshot.insert(snapshot.end(), s.begin(), s.end());
+    std::sort(snapshot.begin(), snapshot.end(), byId);
+
+    const bool fullRange = config.cutoff <= 0.0f || slabCount == 1;
+    forEachSlab(slabCount, config.threads, [&](int s) {
+        if (fullRange) {
+            integrateSlab(slabs[s], snapshot, config, width, height);
+            return;
+        }
+        std::vector<Particle> neighborhood;
+        for (const auto& p : snapshot)
+            if (inHalo(p.x, s, width, slabCount, config.cutoff))
+                neighborhood.push_back(p);
+        integrateSlab(slabs[s], neighborhood, config, width, height);
+    });
+
+    steps++;
+}
+
+void DomainSim::gather(std::vector<Particle>& particles) const {
+    particles.clear();
+    particles.reserve(size());
+    for (const auto& s : slabs) particles.insert(particles.end(), s.begin(), s.end());
+    std::sort(particles.begin(), particles.end(), byId);
+}
+
+size_t DomainSim::size() const {
+    size_t total = 0;
+    for (const auto& s : slabs) total += s.size();
+    return total;
+}
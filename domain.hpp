@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "particle.hpp"
+#include "config.hpp"
+#include "statistics.hpp"
+
+// Разбиение тора width x height на вертикальные полосы (slab) по оси X.
+// Каждая полоса владеет своими частицами и получает от остальных "гало" —
+// копии частиц в пределах радиуса обрезки. Силы считаются по снимку состояния
+// на начало шага, суммирование всегда идёт в порядке id, а случайные события
+// зависят только от (seed, шаг, id) — поэтому результат побитово совпадает
+// при любом числе полос, потоков и процессов.
+struct DomainConfig {
+    int slabs = 1;                   // количество полос
+    int threads = 1;                 // потоков для обработки полос внутри процесса
+    float cutoff = 0.0f;             // радиус взаимодействия, <= 0 — без обрезки (все со всеми)
+    uint64_t seed = 0;               // зерно случайных событий
+    bool enableRandomEvents = false;
+    InteractionMatrix matrix{};      // матрица взаимодействий типов
+};
+
+// Случайное событие, произошедшее с частицей (тип — как в switch в simulate())
+struct DomainEvent {
+    int id;
+    int type;
+};
+
+// --- Операции одного шага, общие для любого транспорта (потоки или MPI) ---
+
+// Номер полосы, которой принадлежит координата x
+int slabOf(float x, int width, int slabs);
+// Нужна ли частица с координатой x полосе slab как гало (расстояние по тору до полосы <= cutoff)
+bool inHalo(float x, int slab, int width, int slabs, float cutoff);
+// Случайные события для частиц полосы. Удалённые частицы исчезают из owned,
+// потомки складываются в children с id родителя (настоящий id выдаёт assignChildIds)
+void applyDomainEvents(std::vector<Particle>& owned, const DomainConfig& config, uint64_t step,
+                       int width, int height, std::vector<DomainEvent>& events, std::vector<Particle>& children);
+// Выдаёт потомкам id, начиная с nextId, в порядке id родителей (parentIds — все родители шага, отсортированы)
+void assignChildIds(std::vector<Particle>& children, const std::vector<int>& parentIds, int nextId);
+// Обновляет скорости и позиции частиц полосы по снимку neighborhood (свои + гало, отсортированы по id)
+void integrateSlab(std::vector<Particle>& owned, const std::vector<Particle>& neighborhood,
+                   const DomainConfig& config, int width, int height);
+// Переносит журнал событий шага в статистику (события упорядочиваются по id)
+void recordDomainEvents(Statistics& stats, std::vector<DomainEvent>& events);
+// Начальные частицы с id 0..count-1, попавшие в полосу slab из slabs. Каждая частица задаётся
+// только (seed, id), поэтому процесс создаёт лишь свои частицы, а общее состояние от числа полос не зависит
+void createSlabParticles(std::vector<Particle>& owned, int count, int width, int height,
+                         uint64_t seed, int slab, int slabs);
+
+// Разбиение внутри одного процесса: полосы обрабатываются параллельно,
+// обмен гало и миграция идут через общую память
+struct DomainSim {
+    int width;
+    int height;
+    DomainConfig config;
+    uint64_t steps = 0;     // номер текущего шага
+    int nextId = 0;         // следующий свободный id для потомков
+    std::vector<std::vector<Particle>> slabs; // частицы каждой полосы
+
+    DomainSim(int w, int h, const DomainConfig& cfg);
+
+    void scatter(const std::vector<Particle>& particles); // раздать частицы по полосам
+    void populate(int count);                              // создать count частиц прямо в полосах (см. createSlabParticles)
+    void step(Statistics& stats);                          // один шаг симуляции
+    void gather(std::vector<Particle>& particles) const;   // собрать все частицы (по возрастанию id)
+    size_t size() const;
+};
@@ -0,0 +1,250 @@
+#include "ensemble.hpp"
+#include "simulation.hpp"
+#include "statistics.hpp"
+#include "group.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+// Число без знака целиком, без хвоста: "12x" и "-3" — ошибка
+static bool parseUnsigned(const std::string& text, unsigned& value) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    try {
+        size_t used = 0;
+        unsigned long parsed = std::stoul(text, &used);
+        if (used != text.size() || parsed > std::numeric_limits<unsigned>::max()) return false;
+        value = static_cast<unsigned>(parsed);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Разбирает зерно "7" или диапазон "1-8"
+static bool parseSeeds(const std::string& token, std::vector<unsigned>& seeds) {
+    size_t dash = token.find('-');
+    unsigned from, to;
+    if (dash == std::string::npos) {
+        if (!parseUnsigned(token, from)) return false;
+        seeds.push_back(from);
+        return true;
+    }
+    if (!parseUnsigned(token.substr(0, dash), from) || !parseUnsigned(token.substr(dash + 1), to) || to < from)
+        return false;
+    for (unsigned s = from; s <= to; ++s) {
+        seeds.push_back(s);
+        if (s == to) break; // to может быть максимальным unsigned
+    }
+    return true;
+}
+
+// Строка разобрана целиком: чтение остановилось на конце строки, а не на лишнем или неверном значении
+static bool atEnd(std::istringstream& in) {
+    if (in.fail() && !in.eof()) return false;
+    in.clear();
+    std::string rest;
+    return !(in >> rest);
+}
+
+// Поле CSV: значения с запятой, кавычкой или переводом строки берутся в кавычки (кавычки внутри удваиваются)
+static std::string csvField(const std::string& value) {
+    if (value.find_first_of(",\"\r\n") == std::string::npos) return value;
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static std::string presetLabel(int preset) {
+    return "preset" + std::to_string(preset);
+}
+
+bool loadSweepSpec(const char* filename, SweepSpec& spec) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Ошибка открытия файла перебора: " << filename << '\n';
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) continue;
+
+        bool ok = true;
+        if (key == "size") {
+            ok = static_cast<bool>(in >> spec.width >> spec.height) && spec.width > 0 && spec.height > 0;
+        } else if (key == "steps") {
+            ok = static_cast<bool>(in >> spec.steps) && spec.steps >= 0;
+        } else if (key == "events") {
+            std::string value;
+            ok = static_cast<bool>(in >> value) && (value == "y" || value == "n");
+            spec.enableRandomEvents = (value == "y");
+        } else if (key == "particles") {
+            int count;
+            size_t before = spec.particleCounts.size();
+            while (in >> count) {
+                if (count <= 0) ok = false;
+                spec.particleCounts.push_back(count);
+            }
+            ok = ok && spec.particleCounts.size() > before;
+        } else if (key == "seeds") {
+            std::string token;
+            size_t before = spec.seeds.size();
+            while (ok && in >> token) ok = parseSeeds(token, spec.seeds);
+            ok = ok && spec.seeds.size() > before;
+        } else if (key == "preset") {
+            int preset;
+            size_t before = spec.matrices.size();
+            while (in >> preset) {
+                if (preset < 1 || preset > 5) ok = false;
+                spec.matrices.push_back({presetLabel(preset), preset, getInteractionMatrix(preset)});
+            }
+            ok = ok && spec.matrices.size() > before;
+        } else if (key == "matrix") {
+            // matrix <имя> <TYPE_COUNT*TYPE_COUNT чисел по строкам>
+            SweepMatrix m;
+            ok = static_cast<bool>(in >> m.label);
+            for (int i = 0; ok && i < TYPE_COUNT * TYPE_COUNT; ++i)
+                ok = static_cast<bool>(in >> m.matrix[i / TYPE_COUNT][i % TYPE_COUNT]);
+            spec.matrices.push_back(m);
+        } else if (key == "scan") {
+            // scan <пресет 1-4> <строка> <столбец> <от> <до> <количество> — перебор одного элемента матрицы
+            int preset, row, col, count;
+            float from, to;
+            ok = static_cast<bool>(in >> preset >> row >> col >> from >> to >> count)
+                 && preset >= 1 && preset <= 4 && row >= 0 && row < TYPE_COUNT
+                 && col >= 0 && col < TYPE_COUNT && count > 0;
+            for (int i = 0; ok && i < count; ++i) {
+                float value = count == 1 ? from : from + (to - from) * i / (count - 1);
+                SweepMatrix m{"", 0, getInteractionMatrix(preset)};
+                m.matrix[row][col] = value;
+                std::ostringstream label;
+                label << presetLabel(preset) << "[" << row << "][" << col << "]=" << value;
+                m.label = label.str();
+                spec.matrices.push_back(m);
+            }
+        } else {
+            ok = false;
+        }
+        // Лишние или нечисловые значения в конце строки — тоже ошибка, а не молча отброшенный хвост
+        ok = ok && atEnd(in);
+
+        if (!ok) {
+            std::cerr << "Ошибка в файле перебора " << filename << ", строка " << lineNumber << ": " << line << '\n';
+            return false;
+        }
+    }
+
+    if (spec.seeds.empty()) spec.seeds.push_back(1);
+    if (spec.matrices.empty() || spec.particleCounts.empty()) {
+        std::cerr << "В файле перебора нужны хотя бы одна матрица (preset/matrix/scan) и одно количество частиц\n";
+        return false;
+    }
+    return true;
+}
+
+std::vector<EnsembleRun> expandSweep(const SweepSpec& spec) {
+    std::vector<EnsembleRun> runs;
+    runs.reserve(spec.matrices.size() * spec.particleCounts.size() * spec.seeds.size());
+    for (const auto& m : spec.matrices)
+        for (int count : spec.particleCounts)
+            for (unsigned seed : spec.seeds)
+                runs.push_back({runs.size(), &m, count, seed});
+    return runs;
+}
+
+std::string runEnsembleMember(const SweepSpec& spec, const EnsembleRun& run) {
+    const SweepMatrix& m = *run.matrix;
+    std::vector<Particle> particles;
+    Statistics stats;
+
+    if (m.preset == 5) {
+        init_group(particles, run.particleCount, spec.width, spec.height, run.seed);
+    } else {
+        reset_particles(particles, run.particleCount, spec.width, spec.height, run.seed);
+    }
+    stats.reset(particles.size());
+    stats.recount(particles);
+
+    // Генератор событий отделён от генератора начального состояния
+    std::seed_seq eventSeed{run.seed, 1u};
+    std::mt19937 rng(eventSeed);
+
+    for (int step = 0; step < spec.steps; ++step) {
+        if (m.preset == 5) {
+            update_group(particles, spec.width, spec.height, stats);
+        } else {
+            simulate(particles, spec.width, spec.height, spec.enableRandomEvents, stats, m.matrix, rng);
+        }
+        stats.incrementStep();
+        stats.updateParticleCount(particles.size());
+    }
+
+    std::ostringstream row;
+    row << run.index << "," << csvField(m.label) << "," << m.preset << "," << run.particleCount << "," << run.seed;
+    for (const auto& matrixRow : m.matrix)
+        for (float value : matrixRow) row << "," << value;
+    row << ",";
+    stats.writeSummaryRow(row, particles);
+    return row.str();
+}
+
+bool runEnsemble(const SweepSpec& spec, const char* outputFilename, int threadCount) {
+    std::ofstream file(outputFilename);
+    if (!file.is_open()) {
+        std::cerr << "Ошибка открытия файла для записи результатов: " << outputFilename << '\n';
+        return false;
+    }
+
+    std::vector<EnsembleRun> runs = expandSweep(spec);
+    std::vector<std::string> rows(runs.size());
+
+    // Прогоны одного размера собираются в пакеты. Пакет — только единица планирования:
+    // одна задача пула выполняет свои прогоны по очереди, каждый своим simulate(),
+    // общего прохода по частицам у них нет. Так задач меньше, а соседние задачи близки по объёму
+    std::stable_sort(runs.begin(), runs.end(), [](const EnsembleRun& a, const EnsembleRun& b) {
+        return a.particleCount < b.particleCount;
+    });
+
+    ThreadPool pool(threadCount);
+    const size_t batchSize = std::clamp<size_t>(runs.size() / (pool.size() * 8), 1, 64);
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t begin = 0; begin < runs.size();) {
+        size_t end = begin;
+        while (end < runs.size() && end - begin < batchSize && runs[end].particleCount == runs[begin].particleCount)
+            ++end;
+        pool.submit([&spec, &runs, &rows, begin, end] {
+            for (size_t i = begin; i < end; ++i)
+                rows[runs[i].index] = runEnsembleMember(spec, runs[i]);
+        });
+        begin = end;
+    }
+    pool.wait();
+
+    file << "Прогон,Матрица,Пресет,Частиц,Seed";
+    for (int i = 0; i < TYPE_COUNT; ++i)
+        for (int j = 0; j < TYPE_COUNT; ++j) file << ",m" << i << j;
+    file << ",";
+    Statistics::writeSummaryHeader(file);
+    file << "\n";
+    for (const auto& row : rows) file << row << "\n";
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Прогонов: " << runs.size() << ", потоков: " << pool.size()
+              << ", время: " << seconds << " с, результаты: " << outputFilename << '\n';
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "config.hpp"
+
+// Вариант матрицы взаимодействий в переборе
+struct SweepMatrix {
+    std::string label;           // имя в файле результатов
+    int preset = 0;              // 1-4 — встроенная матрица, 5 — группировка (update_group), 0 — своя матрица
+    InteractionMatrix matrix{};
+};
+
+// Описание перебора: прогоняются все сочетания matrices x particleCounts x seeds
+struct SweepSpec {
+    int width = 160;
+    int height = 48;
+    int steps = 200;
+    bool enableRandomEvents = false;
+    std::vector<SweepMatrix> matrices;
+    std::vector<int> particleCounts;
+    std::vector<unsigned> seeds;
+};
+
+// Один прогон ансамбля
+struct EnsembleRun {
+    size_t index;                // номер строки в файле результатов
+    const SweepMatrix* matrix;
+    int particleCount;
+    unsigned seed;
+};
+
+// Читает описание перебора из текстового файла (формат — см. sweep_example.txt)
+bool loadSweepSpec(const char* filename, SweepSpec& spec);
+// Раскрывает описание в список прогонов
+std::vector<EnsembleRun> expandSweep(const SweepSpec& spec);
+// Выполняет один прогон и возвращает его строку для файла результатов
+std::string runEnsembleMember(const SweepSpec& spec, const EnsembleRun& run);
+// Выполняет все прогоны на пуле потоков и пишет общий CSV со сводкой Statistics по каждому
+bool runEnsemble(const SweepSpec& spec, const char* outputFilename, int threadCount);
@@ -0,0 +1,264 @@
+#include "frame_writer.hpp"
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// --- PNG без сжатия: deflate из "stored"-блоков, чтобы обойтись без zlib ---
+
+static std::array<uint32_t, 256> makeCrc32Table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[n] = c;
+    }
+    return table;
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    static const std::array<uint32_t, 256> table = makeCrc32Table();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void putBE32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(uint8_t(v >> 24));
+    out.push_back(uint8_t(v >> 16));
+    out.push_back(uint8_t(v >> 8));
+    out.push_back(uint8_t(v));
+}
+
+static void putChunk(std::ostream& file, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    putBE32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    putBE32(chunk, crc32(0, chunk.data() + 4, chunk.size() - 4));
+    file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+static void writePNG(std::ostream& file, const FrameBuffer& frame) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    putBE32(header, static_cast<uint32_t>(frame.width));
+    putBE32(header, static_cast<uint32_t>(frame.height));
+    header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8 бит, RGB, без чересстрочности
+    putChunk(file, "IHDR", header);
+
+    // Строки с фильтром 0 (без фильтрации)
+    const size_t rowBytes = size_t(frame.width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * frame.height);
+    for (int y = 0; y < frame.height; ++y) {
+        raw.push_back(0);
+        raw.insert(raw.end(), frame.rgb.begin() + y * rowBytes, frame.rgb.begin() + (y + 1) * rowBytes);
+    }
+
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    uint32_t a = 1, b = 0; // Adler-32
+    for (size_t pos = 0; pos < raw.size() || pos == 0;) {
+        size_t len = std::min<size_t>(65535, raw.size() - pos);
+        bool last = pos + len == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(uint8_t(len));
+        zlib.push_back(uint8_t(len >> 8));
+        zlib.push_back(uint8_t(~len));
+        zlib.push_back(uint8_t(~len >> 8));
+        for (size_t i = pos; i < pos + len; ++i) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+        if (last) break;
+    }
+    putBE32(zlib, (b << 16) | a);
+    putChunk(file, "IDAT", zlib);
+    putChunk(file, "IEND", {});
+}
+
+static void writePPM(std::ostream& file, const FrameBuffer& frame) {
+    file << "P6\n" << frame.width << " " << frame.height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(frame.rgb.data()), frame.rgb.size());
+}
+
+// Находит в шаблоне единственный %d / %0Nd; возвращает false, если его нет или их несколько
+static bool parsePattern(const std::string& pattern, size_t& begin, size_t& end, int& digits) {
+    begin = pattern.find('%');
+    if (begin == std::string::npos) return false;
+    size_t i = begin + 1;
+    digits = 0;
+    while (i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9')
+        digits = digits * 10 + (pattern[i++] - '0');
+    if (i >= pattern.size() || pattern[i] != 'd' || digits > 12) return false;
+    end = i + 1;
+    return pattern.find('%', end) == std::string::npos;
+}
+
+static std::string frameFileName(const std::string& pattern, size_t index) {
+    size_t begin, end;
+    int digits;
+    parsePattern(pattern, begin, end, digits);
+    std::string number = std::to_string(index);
+    if (static_cast<int>(number.size()) < digits)
+        number.insert(0, digits - number.size(), '0');
+    return pattern.substr(0, begin) + number + pattern.substr(end);
+}
+
+static bool endsWith(const std::string& text, const char* suffix) {
+    size_t n = std::strlen(suffix);
+    return text.size() >= n && text.compare(text.size() - n, n, suffix) == 0;
+}
+
+FrameWriter::FrameWriter(int w, int h, size_t queueCapacity, bool block)
+    : frameWidth(w), frameHeight(h), capacity(queueCapacity ? queueCapacity : 1), blockWhenFull(block) {
+}
+
+FrameWriter::~FrameWriter() {
+    close();
+}
+
+bool FrameWriter::openSequence(const std::string& filePattern) {
+    size_t begin, end;
+    int digits;
+    if (output != Output::None || !parsePattern(filePattern, begin, end, digits)) {
+        std::cerr << "Шаблон имени кадров должен содержать ровно один %d (например, frames/f_%05d.png): "
+                  << filePattern << '\n';
+        return false;
+    }
+    pattern = filePattern;
+    output = endsWith(pattern, ".png") ? Output::PNG : Output::PPM;
+    start();
+    return true;
+}
+
+bool FrameWriter::openPipe(const std::string& command) {
+    if (output != Output::None) return false;
+    // Если кодировщик завершится раньше, запись должна вернуть ошибку, а не убить процесс
+    std::signal(SIGPIPE, SIG_IGN);
+    pipe = popen(command.c_str(), "w");
+    if (!pipe) {
+        std::cerr << "Не удалось запустить программу для кадров: " << command << '\n';
+        return false;
+    }
+    output = Output::Pipe;
+    start();
+    return true;
+}
+
+void FrameWriter::start() {
+    worker = std::thread([this] { run(); });
+}
+
+bool FrameWriter::submit(const std::vector<Particle>& particles, int simWidth, int simHeight) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (output == Output::None || closing || failed) return false;
+    if (queue.size() >= capacity) {
+        if (!blockWhenFull) {
+            framesDropped++;
+            return false;
+        }
+        spaceReady.wait(lock, [this] { return queue.size() < capacity || failed; });
+        if (failed) return false;
+    }
+
+    // Копия частиц в переиспользуемый буфер — единственная работа в потоке симуляции
+    std::vector<Particle> buffer;
+    if (!spare.empty()) {
+        buffer = std::move(spare.back());
+        spare.pop_back();
+    }
+    lock.unlock();
+    buffer.assign(particles.begin(), particles.end());
+    lock.lock();
+    queue.push_back(Job{std::move(buffer), simWidth, simHeight});
+    lock.unlock();
+    jobReady.notify_one();
+    return true;
+}
+
+void FrameWriter::run() {
+    FrameBuffer frame;
+    frame.resize(frameWidth, frameHeight);
+
+    while (true) {
+        Job job;
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this] { return !queue.empty() || closing; });
+            if (queue.empty()) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+            index = framesWritten; // номера без пропусков, даже если часть кадров отброшена
+        }
+        spaceReady.notify_one();
+
+        rasterize(job.particles, job.simWidth, job.simHeight, frame);
+        bool ok = writeFrame(frame, index);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(job.particles));
+        if (!ok) {
+            failed = true;
+            queue.clear();
+            spaceReady.notify_all();
+            return;
+        }
+        framesWritten++;
+    }
+}
+
+bool FrameWriter::writeFrame(const FrameBuffer& frame, size_t index) {
+    if (output == Output::Pipe) {
+        size_t size = frame.rgb.size();
+        if (std::fwrite(frame.rgb.data(), 1, size, pipe) != size) {
+            std::cerr << "Ошибка записи кадра в программу-кодировщик\n";
+            return false;
+        }
+        return true;
+    }
+
+    std::string filename = frameFileName(pattern, index);
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Ошибка открытия файла кадра: " << filename << '\n';
+        return false;
+    }
+    if (output == Output::PNG) writePNG(file, frame);
+    else writePPM(file, frame);
+    return static_cast<bool>(file);
+}
+
+void FrameWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closing) return;
+        closing = true;
+    }
+    jobReady.notify_all();
+    if (worker.joinable()) worker.join();
+    if (pipe) {
+        pclose(pipe);
+        pipe = nullptr;
+    }
+}
+
+size_t FrameWriter::written() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return framesWritten;
+}
+
+size_t FrameWriter::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return framesDropped;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "particle.hpp"
+#include "rasterizer.hpp"
+
+// Запись кадров в фоне. Симуляция только копирует частицы в ограниченную очередь,
+// а растеризация и кодирование идут в отдельном потоке. Если очередь заполнена,
+// кадр пропускается (или, при blockWhenFull, submit ждёт освобождения места).
+//   openSequence("frames/f_%05d.png") — последовательность PNG или PPM (по расширению);
+//   openPipe("ffmpeg -f rawvideo -pix_fmt rgb24 -s 1280x720 -i - out.mp4") — сырые RGB-кадры в stdin программы.
+class FrameWriter {
+public:
+    FrameWriter(int frameWidth, int frameHeight, size_t queueCapacity = 4, bool blockWhenFull = false);
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    bool openSequence(const std::string& pattern);
+    bool openPipe(const std::string& command);
+
+    // Ставит кадр в очередь; false — кадр пропущен (очередь полна или запись остановлена)
+    bool submit(const std::vector<Particle>& particles, int simWidth, int simHeight);
+    // Дописывает оставшиеся кадры и останавливает поток записи
+    void close();
+
+    size_t written() const;
+    size_t dropped() const;
+
+private:
+    enum class Output { None, PPM, PNG, Pipe };
+
+    struct Job {
+        std::vector<Particle> particles;
+        int simWidth;
+        int simHeight;
+    };
+
+    int frameWidth;
+    int frameHeight;
+    size_t capacity;
+    bool blockWhenFull;
+
+    Output output = Output::None;
+    std::string pattern;       // шаблон имени файла с одним %d (%05d и т.п.)
+    FILE* pipe = nullptr;
+
+    mutable std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable spaceReady;
+    std::deque<Job> queue;
+    std::vector<std::vector<Particle>> spare; // буферы для повторного использования
+    bool closing = false;
+    bool failed = false;
+    size_t framesWritten = 0;
+    size_t framesDropped = 0;
+    std::thread worker;
+
+    void start();
+    void run();
+    bool writeFrame(const FrameBuffer& frame, size_t index);
+};
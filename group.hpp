@@ -5,6 +5,7 @@
 #include <random>
 #include "particle.hpp"
 #include "config.hpp"
+#include "statistics.hpp"
 
 constexpr float GROUP_ATTRACT_STRENGTH = 0.1f;      // сильное притяжение для одного типа
 constexpr float GROUP_REPEL_STRENGTH = 0.02f;       // слабое отталкивание для разных типов
@@ -12,11 +13,11 @@ constexpr float MIN_DISTANCE = 1e-3f;
 constexpr float MAX_SPEED = 0.5f;
 constexpr float PARTICLE_RADIUS = 0.5f;
 
-inline void init_group(std::vector<Particle>& particles, int count, int width, int height) {
+inline void init_group(std::vector<Particle>& particles, int count, int width, int height, unsigned seed) {
     particles.clear();
     particles.reserve(count);
 
-    std::mt19937 rng(std::random_device{}());
+    std::mt19937 rng(seed);
     std::uniform_real_distribution<float> distX(0.f, float(width - 1));
     std::uniform_real_distribution<float> distY(0.f, float(height - 1));
     std::uniform_int_distribution<int> distType(0, TYPE_COUNT - 1);
@@ -35,7 +36,11 @@ inline void init_group(std::vector<Particle>& particles, int count, int width, i
     }
 }
 
-inline void update_group(std::vector<Particle>& particles, int width, int height) {
+inline void init_group(std::vector<Particle>& particles, int count, int width, int height) {
+    init_group(particles, count, width, height, std::random_device{}());
+}
+
+inline void update_group(std::vector<Particle>& particles, int width, int height, Statistics& stats) {
     for (auto& p : particles) {
         float forceX = 0.f;
         float forceY = 0.f;
@@ -83,6 +88,7 @@ inline void update_group(std::vector<Particle>& particles, int width, int height
         }
     }
 
+    stats.beginKinematics();
     for (auto& p : particles) {
         p.x += p.vx;
         p.y += p.vy;
@@ -91,5 +97,8 @@ inline void update_group(std::vector<Particle>& particles, int width, int height
         if (p.y < 0) { p.y = 0; p.vy = -p.vy; }
         if (p.x > width - 1) { p.x = width - 1; p.vx = -p.vx; }
         if (p.y > height - 1) { p.y = height - 1; p.vy = -p.vy; }
+
+        stats.addKinematics(p);
     }
+    stats.endKinematics();
 }
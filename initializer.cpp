@@ -0,0 +1,258 @@
+#include "initializer.hpp"
+#include "compact.hpp"
+#include "config.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+
+// Размер блока частиц с собственным генератором. Не зависит от числа потоков —
+// на этом держится воспроизводимость
+static const int INIT_CHUNK = 4096;
+
+// Номера независимых потоков случайных чисел от одного seed
+enum InitStream : unsigned { STREAM_CHUNK = 1, STREAM_CLUSTERS = 2, STREAM_POISSON = 3 };
+
+static std::mt19937 makeRng(unsigned seed, unsigned stream, unsigned index) {
+    std::seed_seq seq{seed, stream, index};
+    return std::mt19937(seq);
+}
+
+// Приведение координаты к [0, size) на торе
+static float wrap(float v, float size) {
+    v = std::fmod(v, size);
+    if (v < 0) v += size;
+    return v >= size ? 0.0f : v;
+}
+
+// Вызывает fn(chunk, begin, end) для всех блоков, распределяя блоки по потокам
+template <typename Fn>
+static void forEachChunk(int count, int threadCount, Fn fn) {
+    const int chunks = (count + INIT_CHUNK - 1) / INIT_CHUNK;
+    auto work = [&](int first, int step) {
+        for (int c = first; c < chunks; c += step)
+            fn(static_cast<unsigned>(c), c * INIT_CHUNK, std::min(count, (c + 1) * INIT_CHUNK));
+    };
+
+    threadCount = std::clamp(threadCount, 1, std::max(1, chunks));
+    if (threadCount == 1) {
+        work(0, 1);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; ++t)
+        workers.emplace_back(work, t, threadCount);
+    for (auto& w : workers) w.join();
+}
+
+// Наименьшее допустимое расстояние PoissonDisk: ближе частицы всё равно "слипаются"
+// (в силах расстояние смягчено на 0.01), а число точек Бридсона растёт как площадь / r^2
+static const float POISSON_MIN_RADIUS = 0.1f;
+// Доля площади на точку при насыщенном заполнении Бридсона: точек выходит около 0.65 * S / r^2,
+// берём с запасом, чтобы первый же проход дал не меньше count точек
+static const float POISSON_FILL = 0.6f;
+
+// Точки без наложений на торе (алгоритм Бридсона). Генерация последовательная и стоит
+// O(S / r^2), поэтому расположение рассчитано на небольшие N. Радиус сразу берётся таким,
+// чтобы count точек поместились (не больше minDistance); если всё же не хватило — r
+// уменьшается. Из полученных точек случайно выбираются count. Пустой результат —
+// count точек не помещаются даже с POISSON_MIN_RADIUS
+static std::vector<std::pair<float, float>> poissonDisk(int count, int width, int height, const InitConfig& config) {
+    std::mt19937 rng = makeRng(config.seed, STREAM_POISSON, 0);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const int attempts = 30;
+
+    std::vector<std::pair<float, float>> points;
+    float r = std::min(config.minDistance, std::sqrt(POISSON_FILL * width * height / std::max(1, count)));
+    while (true) {
+        if (r < POISSON_MIN_RADIUS) return {};
+        const float cell = r / std::sqrt(2.0f);
+        const int cols = std::max(1, static_cast<int>(std::ceil(width / cell)));
+        const int rows = std::max(1, static_cast<int>(std::ceil(height / cell)));
+        std::vector<int> grid(size_t(cols) * rows, -1);
+        std::vector<int> active;
+        points.clear();
+
+        auto cellIndex = [&](float x, float y) {
+            return std::min(rows - 1, static_cast<int>(y / cell)) * cols + std::min(cols - 1, static_cast<int>(x / cell));
+        };
+        auto farEnough = [&](float x, float y) {
+            int cx = std::min(cols - 1, static_cast<int>(x / cell));
+            int cy = std::min(rows - 1, static_cast<int>(y / cell));
+            // ±3 ячейки: последняя ячейка у шва тора может быть неполной
+            for (int dy = -3; dy <= 3; ++dy) {
+                for (int dx = -3; dx <= 3; ++dx) {
+                    int idx = grid[((cy + dy + rows * 4) % rows) * cols + (cx + dx + cols * 4) % cols];
+                    if (idx < 0) continue;
+                    float ddx = std::fabs(points[idx].first - x);
+                    float ddy = std::fabs(points[idx].second - y);
+                    ddx = std::min(ddx, width - ddx);
+                    ddy = std::min(ddy, height - ddy);
+                    if (ddx * ddx + ddy * ddy < r * r) return false;
+                }
+            }
+            return true;
+        };
+        auto add = [&](float x, float y) {
+            grid[cellIndex(x, y)] = static_cast<int>(points.size());
+            active.push_back(static_cast<int>(points.size()));
+            points.emplace_back(x, y);
+        };
+
+        add(unit(rng) * width * 0.999f, unit(rng) * height * 0.999f);
+        while (!active.empty()) {
+            size_t pick = std::min(active.size() - 1, static_cast<size_t>(unit(rng) * active.size()));
+            auto [px, py] = points[active[pick]];
+            bool placed = false;
+            for (int k = 0; k < attempts && !placed; ++k) {
+                float angle = unit(rng) * 6.2831853f;
+                float dist = r * (1.0f + unit(rng));
+                float x = wrap(px + dist * std::cos(angle), float(width));
+                float y = wrap(py + dist * std::sin(angle), float(height));
+                if (farEnough(x, y)) {
+                    add(x, y);
+                    placed = true;
+                }
+            }
+            if (!placed) {
+                active[pick] = active.back();
+                active.pop_back();
+            }
+        }
+
+        if (static_cast<int>(points.size()) >= count) break;
+        r *= 0.9f;
+    }
+
+    // Частичное перемешивание: первые count точек — случайная выборка
+    for (int i = 0; i < count; ++i) {
+        std::uniform_int_distribution<size_t> pickDist(i, points.size() - 1);
+        std::swap(points[i], points[pickDist(rng)]);
+    }
+    points.resize(count);
+    return points;
+}
+
+// Общие для всех блоков данные расположения: центры кластеров и точки пуассоновского диска
+struct LayoutData {
+    std::vector<std::pair<float, float>> centers;
+    std::vector<std::pair<float, float>> positions;
+};
+
+static bool prepareLayout(int count, int width, int height, const InitConfig& config, LayoutData& data) {
+    if (config.layout == Layout::Clustered) {
+        std::mt19937 rng = makeRng(config.seed, STREAM_CLUSTERS, 0);
+        std::uniform_real_distribution<float> distX(0.0f, float(width));
+        std::uniform_real_distribution<float> distY(0.0f, float(height));
+        for (int k = 0; k < std::max(1, config.clusters); ++k)
+            data.centers.emplace_back(distX(rng), distY(rng));
+    }
+    if (config.layout == Layout::PoissonDisk) {
+        data.positions = poissonDisk(count, width, height, config);
+        if (static_cast<int>(data.positions.size()) < count) {
+            std::cerr << "Расположение poisson: " << count << " частиц не помещаются на поле " << width << "x" << height
+                      << " с расстоянием не меньше " << POISSON_MIN_RADIUS << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+// Частицы блока [begin, end) в out[0 .. end-begin) — одинаково для вектора и компактного хранилища
+static void fillChunk(unsigned chunk, int begin, int end, int width, int height, const InitConfig& config,
+                      const LayoutData& data, Particle* out) {
+    const auto& centers = data.centers;
+    const auto& positions = data.positions;
+    std::mt19937 rng = makeRng(config.seed, STREAM_CHUNK, chunk);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<int> distType(0, TYPE_COUNT - 1);
+    std::uniform_real_distribution<float> distMass(config.massMin, config.massMax);
+    std::normal_distribution<float> spread(0.0f, config.clusterRadius);
+
+    for (int i = begin; i < end; ++i) {
+        Particle p;
+        switch (config.layout) {
+            case Layout::Uniform:
+                p.x = unit(rng) * width;
+                p.y = unit(rng) * height;
+                p.type = distType(rng);
+                break;
+            case Layout::Clustered: {
+                size_t k = std::min(centers.size() - 1, static_cast<size_t>(unit(rng) * centers.size()));
+                p.x = wrap(centers[k].first + spread(rng), float(width));
+                p.y = wrap(centers[k].second + spread(rng), float(height));
+                p.type = static_cast<int>(k % TYPE_COUNT);
+                break;
+            }
+            case Layout::Bands:
+                p.type = distType(rng);
+                p.x = wrap((p.type + unit(rng)) * width / TYPE_COUNT, float(width));
+                p.y = unit(rng) * height;
+                break;
+            case Layout::PoissonDisk:
+                p.x = positions[i].first;
+                p.y = positions[i].second;
+                p.type = distType(rng);
+                break;
+        }
+        p.x = wrap(p.x, float(width));
+        p.y = wrap(p.y, float(height));
+        p.vx = 0.0f;
+        p.vy = 0.0f;
+        p.mass = distMass(rng);
+        p.highlightTicks = 0;
+        p.id = i;
+        out[i - begin] = p;
+    }
+}
+
+bool init_particles(std::vector<Particle>& particles, int count, int width, int height, const InitConfig& config) {
+    count = std::max(0, count);
+    LayoutData data;
+    if (!prepareLayout(count, width, height, config, data)) return false;
+    particles.resize(count);
+    forEachChunk(count, config.threads, [&](unsigned chunk, int begin, int end) {
+        fillChunk(chunk, begin, end, width, height, config, data, particles.data() + begin);
+    });
+    return true;
+}
+
+bool init_particles(CompactParticles& particles, int count, int width, int height, const InitConfig& config) {
+    count = std::max(0, count);
+    LayoutData data;
+    if (!prepareLayout(count, width, height, config, data)) return false;
+    particles.assign(count, width, height, config.massMin, config.massMax);
+    // Блок собирается во float-буфере и сразу упаковывается: полный вектор Particle не создаётся
+    forEachChunk(count, config.threads, [&](unsigned chunk, int begin, int end) {
+        std::vector<Particle> buffer(end - begin);
+        fillChunk(chunk, begin, end, width, height, config, data, buffer.data());
+        for (int i = begin; i < end; ++i) particles.set(i, buffer[i - begin]);
+    });
+    return true;
+}
+
+bool parseLayout(const char* name, Layout& layout) {
+    if (!std::strcmp(name, "uniform")) layout = Layout::Uniform;
+    else if (!std::strcmp(name, "clustered")) layout = Layout::Clustered;
+    else if (!std::strcmp(name, "bands")) layout = Layout::Bands;
+    else if (!std::strcmp(name, "poisson")) layout = Layout::PoissonDisk;
+    else return false;
+    return true;
+}
+
+PrebuiltState::~PrebuiltState() {
+    if (pending.valid()) pending.wait();
+}
+
+void PrebuiltState::prepare(std::function<bool(std::vector<Particle>&)> build) {
+    if (pending.valid()) pending.wait();
+    pending = std::async(std::launch::async, [this, build] { return build(next); });
+}
+
+bool PrebuiltState::take(std::vector<Particle>& particles) {
+    if (!pending.valid() || !pending.get()) return false;
+    particles.swap(next);
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <functional>
+#include <future>
+#include <vector>
+#include "particle.hpp"
+
+struct CompactParticles;
+
+// Расположение частиц в начальном состоянии
+enum class Layout {
+    Uniform,     // равномерно по всему полю
+    Clustered,   // несколько кластеров, у каждого свой тип
+    Bands,       // вертикальные полосы по типам
+    PoissonDisk  // равномерно, но без наложений; генерация последовательная — для небольших N (тысячи-десятки тысяч)
+};
+
+struct InitConfig {
+    Layout layout = Layout::Uniform;
+    unsigned seed = 0;
+    int threads = 1;             // потоков заполнения; результат от их числа не зависит
+    float massMin = 1.0f;
+    float massMax = 1.5f;
+    int clusters = 8;            // количество кластеров (Clustered)
+    float clusterRadius = 4.0f;  // разброс частиц вокруг центра кластера (Clustered)
+    float minDistance = 1.0f;    // минимальное расстояние (PoissonDisk; уменьшается, если столько частиц не помещается, но не ниже 0.1)
+};
+
+// Заполняет particles count частицами по config. Частицы пишутся параллельно прямо в вектор
+// блоками фиксированного размера, у каждого блока свой генератор от (seed, номер блока),
+// поэтому при одном seed результат одинаков при любом числе потоков.
+// false (с сообщением в stderr) — частицы не помещаются на поле в расположении PoissonDisk;
+// particles при этом не меняется.
+bool init_particles(std::vector<Particle>& particles, int count, int width, int height, const InitConfig& config);
+// То же сразу в компактное хранилище: блоки упаковываются по мере генерации (те же частицы, что и выше,
+// после квантования), так что в памяти нет полного вектора Particle
+bool init_particles(CompactParticles& particles, int count, int width, int height, const InitConfig& config);
+
+// Имя расположения из командной строки: uniform, clustered, bands, poisson
+bool parseLayout(const char* name, Layout& layout);
+
+// Следующее начальное состояние, которое готовится в фоне — перезапуск ("r") просто
+// подменяет частицы готовым вектором, не дожидаясь генерации
+class PrebuiltState {
+public:
+    ~PrebuiltState();
+
+    void prepare(std::function<bool(std::vector<Particle>&)> build); // начать подготовку в фоне
+    // Забрать готовое состояние (ждёт, если ещё не готово). false — подготовки не было или build
+    // вернул false; particles тогда не меняется
+    bool take(std::vector<Particle>& particles);
+
+private:
+    std::vector<Particle> next;
+    std::future<bool> pending;
+};
@@ -9,14 +9,20 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <array>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <random>
 #include "particle.hpp"
 #include "simulation.hpp"
 #include "renderer.hpp"
 #include "config.hpp"
 #include "statistics.hpp"
 #include "group.hpp"
-
-std::array<std::array<float, TYPE_COUNT>, TYPE_COUNT> interactionMatrix;
+#include "ensemble.hpp"
+#include "frame_writer.hpp"
+#include "initializer.hpp"
+#include "compact.hpp"
 
 // Неблокирующая проверка нажатия клавиш: Настраивает терминал на неблокирующий ввод; 
 // Проверяет наличие символа в буфере ввода;
@@ -46,13 +52,120 @@ int kbhit() {
 }
 
 
-int main() {
+// Режим ансамбля: ParticleSim --ensemble <перебор.txt> [результаты.csv] [--threads N]
+int runEnsembleCommand(int argc, char** argv) {
+    const char* sweepFile = nullptr;
+    const char* outputFile = "ensemble.csv";
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    for (int i = 2; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (!sweepFile) sweepFile = argv[i];
+        else outputFile = argv[i];
+    }
+    if (!sweepFile) {
+        std::cerr << "Использование: " << argv[0] << " --ensemble <перебор.txt> [результаты.csv] [--threads N]\n";
+        return 2;
+    }
+
+    SweepSpec spec;
+    if (!loadSweepSpec(sweepFile, spec)) return 1;
+    return runEnsemble(spec, outputFile, threads) ? 0 : 1;
+}
+
+// Параметры обычного запуска из командной строки
+struct RunOptions {
+    const char* framePattern = nullptr; // --frames: шаблон файлов кадров (frames/f_%05d.png или .ppm)
+    const char* frameCommand = nullptr; // --pipe: программа, получающая сырые RGB-кадры через stdin
+    int frameWidth = 1280;              // --frame-size WxH
+    int frameHeight = 720;
+    bool frameBlock = false;            // --frame-block: ждать запись вместо пропуска кадров
+    int headlessSteps = 0;              // --headless N: N шагов без терминала и пауз
+    int simWidth = 0;                   // --sim-size WxH: размер поля вместо размера терминала (экран показывает его уменьшенным)
+    int simHeight = 0;
+    Layout layout = Layout::Uniform;    // --layout uniform|clustered|bands|poisson
+    bool hasSeed = false;               // --seed S: воспроизводимый запуск (перезапуск k получает S + k)
+    unsigned seed = 0;
+    int initThreads = 0;                // --init-threads N: потоков генерации начального состояния
+    bool compact = false;               // --compact: квантованное хранение частиц (пресеты 1-4)
+    Activity activity;                  // --sleep: пропуск спящих частиц (пресеты 1-4),
+                                        // --sleep-speed X, --sleep-accel X, --sleep-steps N: пороги засыпания
+};
+
+bool parseSize(const char* text, int& width, int& height) {
+    return std::sscanf(text, "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+}
+
+bool parseRunOptions(int argc, char** argv, RunOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--frames") && hasValue) opt.framePattern = argv[++i];
+        else if (!std::strcmp(argv[i], "--pipe") && hasValue) opt.frameCommand = argv[++i];
+        else if (!std::strcmp(argv[i], "--frame-size") && hasValue) {
+            if (!parseSize(argv[++i], opt.frameWidth, opt.frameHeight)) return false;
+        }
+        else if (!std::strcmp(argv[i], "--frame-block")) opt.frameBlock = true;
+        else if (!std::strcmp(argv[i], "--headless") && hasValue) {
+            opt.headlessSteps = std::atoi(argv[++i]);
+            if (opt.headlessSteps <= 0) return false;
+        }
+        else if (!std::strcmp(argv[i], "--sim-size") && hasValue) {
+            if (!parseSize(argv[++i], opt.simWidth, opt.simHeight)) return false;
+        }
+        else if (!std::strcmp(argv[i], "--layout") && hasValue) {
+            if (!parseLayout(argv[++i], opt.layout)) return false;
+        }
+        else if (!std::strcmp(argv[i], "--seed") && hasValue) {
+            opt.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            opt.hasSeed = true;
+        }
+        else if (!std::strcmp(argv[i], "--compact")) opt.compact = true;
+        else if (!std::strcmp(argv[i], "--sleep")) opt.activity.enabled = true;
+        else if (!std::strcmp(argv[i], "--sleep-speed") && hasValue) {
+            opt.activity.speedThreshold = std::strtof(argv[++i], nullptr);
+            if (!(opt.activity.speedThreshold >= 0.0f)) return false;
+        }
+        else if (!std::strcmp(argv[i], "--sleep-accel") && hasValue) {
+            opt.activity.accelThreshold = std::strtof(argv[++i], nullptr);
+            if (!(opt.activity.accelThreshold >= 0.0f)) return false;
+        }
+        else if (!std::strcmp(argv[i], "--sleep-steps") && hasValue) {
+            opt.activity.idleSteps = std::atoi(argv[++i]);
+            if (opt.activity.idleSteps <= 0) return false;
+        }
+        else if (!std::strcmp(argv[i], "--init-threads") && hasValue) {
+            opt.initThreads = std::atoi(argv[++i]);
+            if (opt.initThreads <= 0) return false;
+        }
+        else return false;
+    }
+    return !(opt.framePattern && opt.frameCommand);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && !std::strcmp(argv[1], "--ensemble")) {
+        return runEnsembleCommand(argc, argv);
+    }
+
+    RunOptions options;
+    if (!parseRunOptions(argc, argv, options)) {
+        std::cerr << "Использование: " << argv[0] << " [--frames <шаблон.png|.ppm> | --pipe <команда>]"
+                  << " [--frame-size WxH] [--frame-block] [--headless <шагов>] [--sim-size WxH]\n"
+                  << "       [--layout uniform|clustered|bands|poisson] [--seed S] [--init-threads N] [--compact]\n"
+                  << "       (poisson строится последовательно — для небольшого числа частиц)\n"
+                  << "       [--sleep [--sleep-speed X] [--sleep-accel X] [--sleep-steps N]]\n"
+                  << "       " << argv[0] << " --ensemble <перебор.txt> [результаты.csv] [--threads N]\n";
+        return 2;
+    }
+    const bool headless = options.headlessSteps > 0;
+
     std::srand(std::time(nullptr));
 
     int particleCount = 0;
     do {
         std::cout << "Введите количество частиц (рекомендуется 50 - 500): ";
         std::cin >> particleCount;
+        if (!std::cin) return 1; // ввод закончился (например, ответы переданы через pipe в --headless)
     } while (particleCount <= 0);
 
     int preset = 0;
@@ -65,6 +178,7 @@ int main() {
     do {
         std::cout << "Введите номер пресета (1-5): ";
         std::cin >> preset;
+        if (!std::cin) return 1;
     } while (preset < 1 || preset > 5);
 
     if (preset != 5) {
@@ -76,54 +190,170 @@ int main() {
     do {
         std::cout << "Включить случайные события? (y/n): ";
         std::cin >> ch;
+        if (!std::cin) return 1;
         ch = tolower(ch);
     } while (ch != 'y' && ch != 'n');
     enableRandomEvents = (ch == 'y');
 
+    if (options.compact && preset == 5) {
+        std::cerr << "Компактное хранение поддерживается только для пресетов 1-4\n";
+        return 1;
+    }
+
+    // Усыпление неподвижных частиц работает только в simulate() (пресеты 1-4 без --compact)
+    Activity activity = options.activity;
+    if (activity.enabled && (preset == 5 || options.compact)) {
+        std::cerr << "--sleep поддерживается только для пресетов 1-4 без --compact\n";
+        return 1;
+    }
+
+    // Размер экрана — размер терминала или (без терминала) 160x48. Поле по умолчанию совпадает
+    // с экраном; при --sim-size оно своё, и отрисовка уменьшает его до экрана
+    int termWidth = 160;
+    int termHeight = 48;
     struct winsize w;
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
-    int termWidth = w.ws_col;
-    int termHeight = w.ws_row;
+    if (!headless && ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0 && w.ws_col > 0 && w.ws_row > 0) {
+        termWidth = w.ws_col;
+        termHeight = w.ws_row;
+    }
+    int fieldWidth = termWidth;
+    int fieldHeight = termHeight;
+    if (options.simWidth > 0) {
+        fieldWidth = options.simWidth;
+        fieldHeight = options.simHeight;
+    }
+
+    // Запись кадров в фоне (растеризация не зависит от размера терминала)
+    FrameWriter frameWriter(options.frameWidth, options.frameHeight, 4, options.frameBlock);
+    bool writeFrames = false;
+    if (options.framePattern) {
+        if (!frameWriter.openSequence(options.framePattern)) return 1;
+        writeFrames = true;
+    } else if (options.frameCommand) {
+        if (!frameWriter.openPipe(options.frameCommand)) return 1;
+        writeFrames = true;
+    }
 
     std::vector<Particle> particles;
 
     Statistics stats;
     stats.reset(particleCount);
 
+    // Начальное состояние: перезапуск k получает seed + k, без --seed — случайный
+    InitConfig initConfig;
+    initConfig.layout = options.layout;
+    initConfig.threads = options.initThreads > 0 ? options.initThreads
+                                                 : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int initWidth = fieldWidth;
+    int initHeight = fieldHeight;
     if (preset == 5) {
-        init_group(particles, particleCount, termWidth, termHeight);
+        // Для группировки поле ограничено стенами, а масса частиц одинакова
+        initWidth = fieldWidth - 1;
+        initHeight = fieldHeight - 1;
+        initConfig.massMin = initConfig.massMax = 1.0f;
+    }
+    unsigned restarts = 0;
+    auto nextConfig = [&]() {
+        InitConfig config = initConfig;
+        config.seed = options.hasSeed ? options.seed + restarts : std::random_device{}();
+        restarts++;
+        return config;
+    };
+    auto nextState = [&]() {
+        return [config = nextConfig(), particleCount, initWidth, initHeight](std::vector<Particle>& out) {
+            return init_particles(out, particleCount, initWidth, initHeight, config);
+        };
+    };
+
+    // В компактном режиме частицы генерируются сразу в CompactParticles, а вектор particles
+    // нужен только для отрисовки и кадров — без терминала и кадров он не создаётся вовсе.
+    // Поместятся ли частицы, определяют в основном их число и размер поля, а не seed: отказ
+    // первого состояния завершает программу, отказ при перезапуске оставляет текущее
+    CompactParticles compactParticles;
+    const bool needDecoded = !headless || writeFrames;
+    if (options.compact) {
+        if (particleCount > CompactParticles::MAX_ID + 1) {
+            std::cerr << "Компактное хранение поддерживает не больше " << CompactParticles::MAX_ID + 1 << " частиц\n";
+            return 1;
+        }
+        if (!init_particles(compactParticles, particleCount, initWidth, initHeight, nextConfig())) return 1;
+        recount_compact(compactParticles, stats);
+        if (needDecoded) compactParticles.decode(particles);
+        std::cout << "Компактное хранение: " << compactParticles.bytesPerParticle() << " байт на частицу вместо "
+                  << sizeof(Particle) << '\n';
     } else {
-        reset_particles(particles, particleCount, termWidth, termHeight);
+        if (!nextState()(particles)) return 1;
+        stats.recount(particles);
     }
 
+    // Следующее состояние готовится в фоне, чтобы "r" срабатывал сразу. Компактный режим
+    // этого не делает: второе готовое состояние удвоило бы память, ради которой он включён
+    PrebuiltState prebuilt;
+    if (!headless && !options.compact) prebuilt.prepare(nextState());
+
+    std::mt19937 rng(options.hasSeed ? options.seed : std::random_device{}());
+
     while (true) {
-        if (kbhit()) {
+        if (!headless && kbhit()) {
             char input = getchar();
             if (input == 'q') break;
             if (input == 'r') {
-                if (preset == 5) {
-                    init_group(particles, particleCount, termWidth, termHeight);
+                bool restarted;
+                if (options.compact) {
+                    restarted = init_particles(compactParticles, particleCount, initWidth, initHeight, nextConfig());
+                    if (restarted && needDecoded) compactParticles.decode(particles);
+                } else {
+                    restarted = prebuilt.take(particles);
+                    prebuilt.prepare(nextState());
+                }
+                if (!restarted) {
+                    std::cerr << "Перезапуск не удался, продолжается текущее состояние\n";
                 } else {
-                    reset_particles(particles, particleCount, termWidth, termHeight);
+                    stats.reset(particleCount);
+                    if (options.compact) recount_compact(compactParticles, stats);
+                    else stats.recount(particles);
+                    activity.reset();
                 }
-                stats.reset(particleCount);
             }
         }
 
-        if (preset == 5) {
-            update_group(particles, termWidth, termHeight);
+        if (options.compact) {
+            simulate_compact(compactParticles, enableRandomEvents, stats, interactionMatrix, rng);
+            if (needDecoded) compactParticles.decode(particles);
+        } else if (preset == 5) {
+            update_group(particles, fieldWidth, fieldHeight, stats);
         } else {
-            simulate(particles, termWidth, termHeight, enableRandomEvents, stats);
+            simulate(particles, fieldWidth, fieldHeight, enableRandomEvents, stats, interactionMatrix, rng, &activity);
         }
         stats.incrementStep();
-        stats.updateParticleCount(particles.size());
+        stats.updateParticleCount(options.compact ? compactParticles.size() : particles.size());
 
-        render(particles, termWidth, termHeight);
+        if (writeFrames) frameWriter.submit(particles, fieldWidth, fieldHeight);
+
+        if (headless) {
+            if (stats.simulationSteps >= static_cast<size_t>(options.headlessSteps)) break;
+            continue;
+        }
+        render(particles, fieldWidth, fieldHeight, termWidth, termHeight);
+        render_hud(stats, termWidth);
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
 
-    stats.printSummary(particles);
-    stats.saveToCSV(particles, "statistics.csv");
+    if (writeFrames) {
+        frameWriter.close();
+        std::cout << "Кадров записано: " << frameWriter.written()
+                  << ", пропущено (очередь заполнена): " << frameWriter.dropped() << '\n';
+    }
+
+    if (options.compact) {
+        // Итоги по агрегатам — распаковывать всё хранилище ради сводки не нужно
+        recount_compact(compactParticles, stats);
+        stats.printTotals(compactParticles.size());
+        stats.saveTotalsToCSV("statistics.csv");
+    } else {
+        stats.printSummary(particles);
+        stats.saveToCSV(particles, "statistics.csv");
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <cmath>
+#include "particle.hpp"
+
+// Общее ядро шага для всех движков: simulate(), simulate_compact() и полос DomainSim.
+// Изменение констант или формул здесь меняет их все одинаково
+
+constexpr float FRICTION = 0.1f;      // доля скорости, теряемая за шаг
+constexpr float SPEED_FACTOR = 0.1f;  // перевод ускорения в приращение скорости
+constexpr float SOFTENING = 0.01f;    // смещение квадрата расстояния для предотвращения деления на 0
+constexpr float EVENT_CHANCE = 0.01f; // вероятность случайного события для частицы за шаг
+
+// Вклад соседа со смещением (dx, dy), силой взаимодействия force и массой mass в ускорение (ax, ay).
+// Смещение берётся кратчайшим по тору; cutoffSq > 0 отбрасывает соседей дальше радиуса обрезки
+inline void accumulatePair(float dx, float dy, int width, int height, float force, float mass,
+                           float cutoffSq, float& ax, float& ay) {
+    // Торроидальное (периодическое) пространство
+    if (dx > width / 2) dx -= width;
+    else if (dx < -width / 2) dx += width;
+    if (dy > height / 2) dy -= height;
+    else if (dy < -height / 2) dy += height;
+
+    if (cutoffSq > 0.0f && dx * dx + dy * dy > cutoffSq) return;
+
+    float dist_sq = dx * dx + dy * dy + SOFTENING;
+    float dist = std::sqrt(dist_sq);
+    float accel = force * mass / dist_sq;
+
+    ax += accel * dx / dist;
+    ay += accel * dy / dist;
+}
+
+// Скорость от ускорения с трением и сдвиг частицы (без возврата на тор)
+inline void integrateParticle(Particle& p, float ax, float ay) {
+    p.vx += ax * SPEED_FACTOR;
+    p.vy += ay * SPEED_FACTOR;
+
+    p.vx *= (1.0f - FRICTION);
+    p.vy *= (1.0f - FRICTION);
+
+    p.x += p.vx;
+    p.y += p.vy;
+}
+
+// Обеспечение цикличности по краям
+inline void wrapToTorus(Particle& p, int width, int height) {
+    if (p.x < 0) p.x += width;
+    if (p.x >= width) p.x -= width;
+    if (p.y < 0) p.y += height;
+    if (p.y >= height) p.y -= height;
+}
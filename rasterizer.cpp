@@ -0,0 +1,75 @@
+#include "rasterizer.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Цвета типов — те же, что в терминальной отрисовке (красный, зелёный, синий)
+static const uint8_t TYPE_RGB[3][3] = {
+    { 230,  60,  60 },
+    {  60, 210,  80 },
+    {  70, 110, 240 }
+};
+static const uint8_t BACKGROUND_RGB[3] = { 12, 12, 18 };
+static const uint8_t GLOW_RGB[3] = { 255, 220, 60 };
+static const float GLOW_SCALE = 2.5f; // радиус ореола в радиусах частицы
+static const int MAX_HIGHLIGHT = 5;   // highlightTicks сразу после события
+
+void FrameBuffer::resize(int w, int h) {
+    width = w;
+    height = h;
+    rgb.resize(size_t(w) * h * 3);
+}
+
+// Смешивает цвет пикселя с color с долей alpha (0..1)
+static void blend(uint8_t* pixel, const uint8_t* color, float alpha) {
+    for (int c = 0; c < 3; ++c)
+        pixel[c] = static_cast<uint8_t>(pixel[c] + (color[c] - pixel[c]) * alpha);
+}
+
+// Проходит по пикселям круга радиуса radius с центром (cx, cy), заворачивая края по тору
+template <typename Fn>
+static void forEachPixelInDisc(FrameBuffer& frame, float cx, float cy, float radius, Fn fn) {
+    int x0 = static_cast<int>(std::floor(cx - radius));
+    int x1 = static_cast<int>(std::ceil(cx + radius));
+    int y0 = static_cast<int>(std::floor(cy - radius));
+    int y1 = static_cast<int>(std::ceil(cy + radius));
+    float r2 = radius * radius;
+
+    for (int y = y0; y <= y1; ++y) {
+        float dy = y + 0.5f - cy;
+        int py = ((y % frame.height) + frame.height) % frame.height;
+        for (int x = x0; x <= x1; ++x) {
+            float dx = x + 0.5f - cx;
+            float d2 = dx * dx + dy * dy;
+            if (d2 > r2) continue;
+            int px = ((x % frame.width) + frame.width) % frame.width;
+            fn(&frame.rgb[(size_t(py) * frame.width + px) * 3], std::sqrt(d2) / radius);
+        }
+    }
+}
+
+void rasterize(const std::vector<Particle>& particles, int simWidth, int simHeight, FrameBuffer& frame) {
+    for (size_t i = 0; i < frame.rgb.size(); i += 3)
+        std::copy(BACKGROUND_RGB, BACKGROUND_RGB + 3, &frame.rgb[i]);
+    if (frame.width <= 0 || frame.height <= 0 || simWidth <= 0 || simHeight <= 0) return;
+
+    const float sx = float(frame.width) / simWidth;
+    const float sy = float(frame.height) / simHeight;
+    const float radius = std::max(0.75f, 0.5f * std::min(sx, sy));
+
+    // Сначала ореолы, чтобы сами частицы рисовались поверх
+    for (const auto& p : particles) {
+        if (p.highlightTicks <= 0) continue;
+        float strength = std::min(p.highlightTicks, MAX_HIGHLIGHT) / float(MAX_HIGHLIGHT);
+        forEachPixelInDisc(frame, p.x * sx, p.y * sy, radius * GLOW_SCALE, [&](uint8_t* pixel, float r) {
+            blend(pixel, GLOW_RGB, 0.6f * strength * (1.0f - r));
+        });
+    }
+
+    for (const auto& p : particles) {
+        const uint8_t* color = TYPE_RGB[((p.type % 3) + 3) % 3];
+        forEachPixelInDisc(frame, p.x * sx, p.y * sy, radius, [&](uint8_t* pixel, float r) {
+            // Мягкий край толщиной в четверть радиуса
+            blend(pixel, color, std::min(1.0f, (1.0f - r) * 4.0f));
+        });
+    }
+}
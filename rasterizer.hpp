@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "particle.hpp"
+
+// RGB-кадр (по 3 байта на пиксель, строки сверху вниз)
+struct FrameBuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgb;
+
+    void resize(int w, int h);
+};
+
+// Рисует частицы в кадр произвольного размера: поле simWidth x simHeight растягивается
+// на весь кадр, частица — круг цвета своего типа, подсвеченные (highlightTicks) — с жёлтым ореолом
+void rasterize(const std::vector<Particle>& particles, int simWidth, int simHeight, FrameBuffer& frame);
@@ -1,6 +1,9 @@
 #include "renderer.hpp"
 #include "config.hpp"
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
 
 const char typeChars[] = { 'o', '*', '+' };
 const char* typeColors[] = {
@@ -11,28 +14,26 @@ const char* typeColors[] = {
 const char* HIGHLIGHT_COLOR = "\033[1;43m"; // фон
 const char* RESET_COLOR = "\033[0m";
 
-void render(const std::vector<Particle>& particles, int width, int height) {
-    const int GRID_WIDTH = width;
-    const int GRID_HEIGHT = height;
-    char grid[GRID_HEIGHT][GRID_WIDTH];
-    int type[GRID_HEIGHT][GRID_WIDTH];
-    const Particle* owner[GRID_HEIGHT][GRID_WIDTH];
-
-    for (int y = 0; y < GRID_HEIGHT; ++y) {
-        for (int x = 0; x < GRID_WIDTH; ++x) {
-            grid[y][x] = ' ';
-            type[y][x] = -1;
-            owner[y][x] = nullptr;
-        }
-    }
+void render(const std::vector<Particle>& particles, int fieldWidth, int fieldHeight, int screenWidth, int screenHeight) {
+    const int GRID_WIDTH = screenWidth;
+    const int GRID_HEIGHT = screenHeight;
+    // Буферы размером с экран, а не с поле — поле может быть сколь угодно большим (--sim-size)
+    const size_t cells = size_t(GRID_WIDTH) * GRID_HEIGHT;
+    std::vector<char> grid(cells, ' ');
+    std::vector<int> type(cells, -1);
+    std::vector<const Particle*> owner(cells, nullptr);
 
+    // Координаты поля переводятся в клетки экрана (при равных размерах масштаб ровно 1)
+    const float scaleX = float(GRID_WIDTH) / fieldWidth;
+    const float scaleY = float(GRID_HEIGHT) / fieldHeight;
     for (const auto& p : particles) {
-        int gx = static_cast<int>(p.x);
-        int gy = static_cast<int>(p.y);
+        int gx = static_cast<int>(p.x * scaleX);
+        int gy = static_cast<int>(p.y * scaleY);
         if (gx >= 0 && gx < GRID_WIDTH && gy >= 0 && gy < GRID_HEIGHT) {
-            grid[gy][gx] = typeChars[p.type % 3];
-            type[gy][gx] = p.type % 3;
-            owner[gy][gx] = &p;
+            size_t cell = size_t(gy) * GRID_WIDTH + gx;
+            grid[cell] = typeChars[p.type % 3];
+            type[cell] = p.type % 3;
+            owner[cell] = &p;
         }
     }
 
@@ -40,11 +41,12 @@ void render(const std::vector<Particle>& particles, int width, int height) {
     std::cout << "\033[2J\033[1;1H";
     for (int y = 0; y < GRID_HEIGHT; ++y) {
         for (int x = 0; x < GRID_WIDTH; ++x) {
-            if (type[y][x] != -1 && owner[y][x]) {
-                if (owner[y][x]->highlightTicks > 0)
-                    std::cout << HIGHLIGHT_COLOR << typeColors[type[y][x]] << grid[y][x] << RESET_COLOR;
+            size_t cell = size_t(y) * GRID_WIDTH + x;
+            if (type[cell] != -1 && owner[cell]) {
+                if (owner[cell]->highlightTicks > 0)
+                    std::cout << HIGHLIGHT_COLOR << typeColors[type[cell]] << grid[cell] << RESET_COLOR;
                 else
-                    std::cout << typeColors[type[y][x]] << grid[y][x] << RESET_COLOR;
+                    std::cout << typeColors[type[cell]] << grid[cell] << RESET_COLOR;
             } else {
                 std::cout << ' ';
             }
@@ -53,3 +55,37 @@ void render(const std::vector<Particle>& particles, int width, int height) {
     }
     std::cout.flush();
 }
+
+
+// Обрезает UTF-8 строку до maxChars символов (не разрывая многобайтные символы)
+static std::string truncateUtf8(const std::string& text, int maxChars) {
+    int chars = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if ((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80 && chars++ == maxChars)
+            return text.substr(0, i);
+    }
+    return text;
+}
+
+void render_hud(const Statistics& stats, int width) {
+    const char typeNames[] = { 'R', 'G', 'B' };
+    int total = 0;
+    for (int cnt : stats.countByType) total += cnt;
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2)
+         << " Шаг " << stats.simulationSteps << " | Частиц " << total;
+    for (int t = 0; t < TYPE_COUNT; ++t) {
+        int cnt = stats.countByType[t];
+        line << " | " << typeNames[t % 3] << ": " << cnt;
+        if (cnt > 0)
+            line << " m=" << stats.massSumByType[t] / cnt << " v=" << stats.speedSumByType[t] / cnt;
+    }
+    line << " | Событий " << stats.totalRandomEvents;
+    if (stats.dormantParticles > 0)
+        line << " | Спят " << stats.dormantParticles;
+    line << ' ';
+
+    std::cout << "\033[1;1H\033[7m" << truncateUtf8(line.str(), width) << RESET_COLOR << "\033[K";
+    std::cout.flush();
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include <vector>
 #include "particle.hpp"
+#include "statistics.hpp"
 
-void render(const std::vector<Particle>& particles, int width, int height);
+// Поле fieldWidth x fieldHeight, уменьшенное (или растянутое) до экрана screenWidth x screenHeight символов
+void render(const std::vector<Particle>& particles, int fieldWidth, int fieldHeight, int screenWidth, int screenHeight);
+// Строка состояния поверх первой строки поля: шаг и агрегаты по типам (O(TYPE_COUNT))
+void render_hud(const Statistics& stats, int width);
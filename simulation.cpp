@@ -1,17 +1,22 @@
 #include "simulation.hpp"
 #include "config.hpp"
+#include "physics.hpp"
 #include <cstdlib>
 #include <cmath>
 #include <random>
 #include <unordered_set>
 
-extern std::array<std::array<float, TYPE_COUNT>, TYPE_COUNT> interactionMatrix;
+InteractionMatrix interactionMatrix;
 
 void reset_particles(std::vector<Particle>& particles, int count, int width, int height) {
+    reset_particles(particles, count, width, height, std::random_device{}());
+}
+
+void reset_particles(std::vector<Particle>& particles, int count, int width, int height, unsigned seed) {
     particles.clear();
     particles.reserve(count);
 
-    std::mt19937 rng(std::random_device{}());
+    std::mt19937 rng(seed);
     std::uniform_real_distribution<float> distX(0, width);
     std::uniform_real_distribution<float> distY(0, height);
     std::uniform_int_distribution<int> distType(0, TYPE_COUNT - 1);
@@ -32,122 +37,153 @@ void reset_particles(std::vector<Particle>& particles, int count, int width, int
 }
 
 void simulate(std::vector<Particle>& particles, int width, int height, bool enableRandomEvents, Statistics& stats) {
-    const float friction = 0.1f;
-    const float baseSpeedFactor = 0.1f;
-
     static std::mt19937 rng(std::random_device{}());
+    simulate(particles, width, height, enableRandomEvents, stats, interactionMatrix, rng);
+}
+
+int random_event(Particle& p, Particle& child, int width, int height, Statistics& stats, std::mt19937& rng) {
     std::uniform_real_distribution<float> distProb(0.0f, 1.0f);
     std::uniform_int_distribution<int> distType(0, TYPE_COUNT - 1);
     std::uniform_real_distribution<float> distMass(1.0f, 1.5f);
     std::uniform_real_distribution<float> distShift(-1.0f, 1.0f);
     std::uniform_int_distribution<int> distEvent(0, 6);
 
+    if (distProb(rng) >= EVENT_CHANCE) return -1;
+
+    int eventType = distEvent(rng);
+    stats.totalRandomEvents++;
+    stats.recordRandomEvent(p.id);
+
+    switch (eventType) {
+        case 0:
+            stats.removedParticles++;
+            stats.removeParticle(p);
+            break;
+        case 1: {
+            stats.typeChanges++;
+            int oldType = p.type;
+            p.type = distType(rng);
+            stats.changeType(p, oldType);
+            p.highlightTicks = 5;
+            break;
+        }
+        case 2:
+            stats.reproductions++;
+            child = p;
+            child.x += distShift(rng);
+            child.y += distShift(rng);
+            child.mass = distMass(rng);
+            child.vx = 0.0f;
+            child.vy = 0.0f;
+            child.highlightTicks = 5;
+            p.highlightTicks = 5;
+            break;
+        case 3:
+            stats.teleports++;
+            p.x = distProb(rng) * width;
+            p.y = distProb(rng) * height;
+            p.highlightTicks = 5;
+            break;
+        case 4: {
+            stats.massChanges++;
+            float oldMass = p.mass;
+            p.mass = distMass(rng);
+            stats.changeMass(p, oldMass);
+            p.highlightTicks = 5;
+            break;
+        }
+        case 5:
+            stats.speedJumps++;
+            p.vx = distShift(rng) * 2.0f;
+            p.vy = distShift(rng) * 2.0f;
+            p.highlightTicks = 5;
+            break;
+        case 6:
+            stats.sleepingParticles++;
+            p.vx = 0.0f;
+            p.vy = 0.0f;
+            p.highlightTicks = 5;
+            break;
+    }
+    return eventType;
+}
+
+void simulate(std::vector<Particle>& particles, int width, int height, bool enableRandomEvents, Statistics& stats,
+              const InteractionMatrix& matrix, std::mt19937& rng, Activity* activity) {
+    // Учёт спящих частиц включается только при переданной и включённой Activity
+    Activity* active = (activity && activity->enabled) ? activity : nullptr;
+    int dormant = 0;
+    if (active) active->beginStep(width, height, particles.size());
+
+    stats.beginKinematics();
+
     for (size_t i = 0; i < particles.size(); ++i) {
+        // Запас места под потомка, чтобы push_back в событии размножения не сделал ссылку p висячей
+        if (enableRandomEvents && particles.size() == particles.capacity())
+            particles.reserve(particles.size() * 2 + 1);
         auto& p = particles[i];
 
         // Случайные события
         if (enableRandomEvents) {
-            float eventChance = 0.01f;
-            if (distProb(rng) < eventChance) {
-                int eventType = distEvent(rng);
-                stats.totalRandomEvents++;
-                stats.recordRandomEvent(p.id);
-
-                switch (eventType) {
-                    case 0:
-                        stats.removedParticles++;
-                        particles.erase(particles.begin() + i);
-                        --i;
-                        continue;
-                    case 1:
-                        stats.typeChanges++;
-                        p.type = distType(rng);
-                        p.highlightTicks = 5;
-                        break;
-                    case 2: {
-                        stats.reproductions++;
-                        Particle child = p;
-                        child.x += distShift(rng);
-                        child.y += distShift(rng);
-                        child.mass = distMass(rng);
-                        child.vx = 0.0f;
-                        child.vy = 0.0f;
-                        child.highlightTicks = 5;
-                        child.id = static_cast<int>(particles.size());
-                        particles.push_back(child);
-                        p.highlightTicks = 5;
-                        break;
-                    }
-                    case 3:
-                        stats.teleports++;
-                        p.x = distProb(rng) * width;
-                        p.y = distProb(rng) * height;
-                        p.highlightTicks = 5;
-                        break;
-                    case 4:
-                        stats.massChanges++;
-                        p.mass = distMass(rng);
-                        p.highlightTicks = 5;
-                        break;
-                    case 5:
-                        stats.speedJumps++;
-                        p.vx = distShift(rng) * 2.0f;
-                        p.vy = distShift(rng) * 2.0f;
-                        p.highlightTicks = 5;
-                        break;
-                    case 6:
-                        stats.sleepingParticles++;
-                        p.vx = 0.0f;
-                        p.vy = 0.0f;
-                        p.highlightTicks = 5;
-                        break;
+            float eventX = p.x;
+            float eventY = p.y;
+            Particle child;
+            int eventType = random_event(p, child, width, height, stats, rng);
+
+            if (eventType == 0) {
+                if (active) {
+                    active->markChanged(eventX, eventY);
+                    active->erase(i);
                 }
+                particles.erase(particles.begin() + i);
+                --i;
+                continue;
+            }
+            if (eventType == 2) {
+                child.id = static_cast<int>(particles.size());
+                stats.addParticle(child);
+                particles.push_back(child);
+                if (active) active->add();
+            }
+
+            // Событие будит частицу, а "усыпление" (случай 6) сразу делает её спящей
+            if (active && eventType >= 0) {
+                if (eventType == 6) active->putToSleep(i);
+                else active->touch(i, p, eventX, eventY);
             }
         }
 
+        if (active && active->isDormant(i) && !active->neighborhoodChanged(p.x, p.y)) {
+            dormant++;
+            if (p.highlightTicks > 0)
+                p.highlightTicks--;
+            stats.addKinematics(p);
+            continue;
+        }
+
+        float startX = p.x;
+        float startY = p.y;
         float ax = 0.0f;
         float ay = 0.0f;
         for (const auto& other : particles) {
             if (&p == &other) continue;
-
-            float dx = other.x - p.x;
-            float dy = other.y - p.y;
-
-            // Торроидальное (периодическое) пространство
-            if (dx > width / 2) dx -= width;
-            else if (dx < -width / 2) dx += width;
-            if (dy > height / 2) dy -= height;
-            else if (dy < -height / 2) dy += height;
-
-            float dist_sq = dx * dx + dy * dy + 0.01f; // Смещение для предотвращения деления на 0
-            float dist = std::sqrt(dist_sq);
-
-            int t1 = p.type;
-            int t2 = other.type;
-            float force = interactionMatrix[t1][t2];
-            float accel = force * other.mass / dist_sq;
-
-            ax += accel * dx / dist;
-            ay += accel * dy / dist;
+            accumulatePair(other.x - p.x, other.y - p.y, width, height, matrix[p.type][other.type], other.mass,
+                           0.0f, ax, ay);
         }
 
-        p.vx += ax * baseSpeedFactor;
-        p.vy += ay * baseSpeedFactor;
-
-        p.vx *= (1.0f - friction);
-        p.vy *= (1.0f - friction);
-
-        p.x += p.vx;
-        p.y += p.vy;
-
-        // Обеспечение цикличности по краям
-        if (p.x < 0) p.x += width;
-        if (p.x >= width) p.x -= width;
-        if (p.y < 0) p.y += height;
-        if (p.y >= height) p.y -= height;
+        integrateParticle(p, ax, ay);
+        wrapToTorus(p, width, height);
 
         if (p.highlightTicks > 0)
             p.highlightTicks--;
+
+        if (active) active->afterIntegration(i, p, startX, startY, ax * SPEED_FACTOR, ay * SPEED_FACTOR);
+
+        stats.addKinematics(p);
     }
+
+    stats.endKinematics();
+    stats.dormantParticles = dormant;
+    if (active) active->endStep();
 }
 
@@ -1,8 +1,25 @@
 #pragma once
+#include <array>
+#include <random>
 #include <vector>
 #include "particle.hpp"
 #include "statistics.hpp"
+#include "config.hpp"
+#include "activity.hpp"
+
+// Текущая матрица взаимодействий типов (выбирается пресетом в main())
+extern InteractionMatrix interactionMatrix;
 
 // Создаёт count частиц с начальными случайными параметрами и добавляет их в particles
 void reset_particles(std::vector<Particle>& particles, int count, int width, int height);
-void simulate(std::vector<Particle>& particles, int width, int height, bool enableRandomEvents, Statistics& stats);
\ No newline at end of file
+// То же, но с заданным зерном генератора — одинаковое начальное состояние при одинаковом seed
+void reset_particles(std::vector<Particle>& particles, int count, int width, int height, unsigned seed);
+void simulate(std::vector<Particle>& particles, int width, int height, bool enableRandomEvents, Statistics& stats);
+// Случайное событие шага для частицы p (с вероятностью 1%): меняет p и счётчики stats.
+// Возвращает номер события или -1. Удаление (0) и добавление потомка (2, потомок пишется в child
+// без id) выполняет вызывающий — общая часть simulate() и simulate_compact()
+int random_event(Particle& p, Particle& child, int width, int height, Statistics& stats, std::mt19937& rng);
+// Шаг с явной матрицей и генератором — не трогает глобальное состояние, можно вызывать из нескольких потоков.
+// activity (если передана и включена) позволяет пропускать спящие частицы
+void simulate(std::vector<Particle>& particles, int width, int height, bool enableRandomEvents, Statistics& stats,
+              const InteractionMatrix& matrix, std::mt19937& rng, Activity* activity = nullptr);
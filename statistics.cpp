@@ -1,4 +1,5 @@
 #include "statistics.hpp"
+#include "config.hpp"
 #include <iostream>
 #include <fstream>
 #include <cmath>
@@ -34,10 +35,16 @@ void Statistics::reset(size_t particleCount) {
     speedJumps = 0;
     totalRandomEvents = 0;
     particlesWithEvents = 0;
+    dormantParticles = 0;
     simulationSteps = 0;
     totalParticleCount = 0;
     hadRandomEvent.assign(particleCount, false);  // флаг событий на каждую частицу
     topMassiveParticles.clear();
+    countByType.fill(0);
+    massSumByType.fill(0.0);
+    momentumXByType.fill(0.0);
+    momentumYByType.fill(0.0);
+    speedSumByType.fill(0.0);
 }
 
 // Учитывает событие, произошедшее с конкретной частицей (уникальное по индексу)
@@ -77,6 +84,75 @@ void Statistics::updateParticleCount(size_t count) {
     totalParticleCount += count;
 }
 
+// Пересчитывает агрегаты по типам с нуля — нужен один раз после создания частиц
+void Statistics::recount(const std::vector<Particle>& particles) {
+    beginRecount();
+    for (const auto& p : particles) recountParticle(p);
+    endRecount();
+}
+
+void Statistics::beginRecount() {
+    countByType.fill(0);
+    massSumByType.fill(0.0);
+    beginKinematics();
+}
+
+void Statistics::recountParticle(const Particle& p) {
+    addParticle(p);
+    addKinematics(p);
+}
+
+void Statistics::endRecount() {
+    endKinematics();
+}
+
+bool Statistics::aggregatesMatch(size_t particleCount) const {
+    size_t counted = 0;
+    for (int c : countByType) counted += static_cast<size_t>(std::max(c, 0));
+    return counted == particleCount;
+}
+
+void Statistics::addParticle(const Particle& p) {
+    countByType[p.type]++;
+    massSumByType[p.type] += p.mass;
+}
+
+void Statistics::removeParticle(const Particle& p) {
+    countByType[p.type]--;
+    massSumByType[p.type] -= p.mass;
+}
+
+void Statistics::changeType(const Particle& p, int oldType) {
+    countByType[oldType]--;
+    massSumByType[oldType] -= p.mass;
+    countByType[p.type]++;
+    massSumByType[p.type] += p.mass;
+}
+
+void Statistics::changeMass(const Particle& p, float oldMass) {
+    massSumByType[p.type] += double(p.mass) - double(oldMass);
+}
+
+// Импульс и скорости меняются у всех частиц на каждом шаге, поэтому они не корректируются
+// по разнице, а накапливаются заново прямо в цикле интегрирования
+void Statistics::beginKinematics() {
+    stepMomentumX.fill(0.0);
+    stepMomentumY.fill(0.0);
+    stepSpeedSum.fill(0.0);
+}
+
+void Statistics::addKinematics(const Particle& p) {
+    stepMomentumX[p.type] += p.mass * p.vx;
+    stepMomentumY[p.type] += p.mass * p.vy;
+    stepSpeedSum[p.type] += std::sqrt(p.vx * p.vx + p.vy * p.vy);
+}
+
+void Statistics::endKinematics() {
+    momentumXByType = stepMomentumX;
+    momentumYByType = stepMomentumY;
+    speedSumByType = stepSpeedSum;
+}
+
 // Вычисляет евклидово расстояние между двумя точками
 static double dist(double x1, double y1, double x2, double y2) {
     double dx = x2 - x1;
@@ -84,36 +160,21 @@ static double dist(double x1, double y1, double x2, double y2) {
     return std::sqrt(dx*dx + dy*dy);
 }
 
-// Основная функция — печать всей статистики симуляции
-void Statistics::printSummary(const std::vector<Particle>& particles) {
+// Количество и масса по типам (агрегаты поддерживаются симуляцией) и счётчики событий
+void Statistics::printTypeTotals(size_t count) const {
     using namespace std;
-
-    size_t count = particles.size();
-    if (count == 0) {
-        cout << "Нет частиц для статистики.\n";
-        return;
-    }
-
-    cout << "\n--- Итоговая статистика симуляции ---\n";
-
-    // --- Подсчёт количества и массы по типам ---
-    map<int, int> countByType;
-    map<int, double> massSumByType;
-    for (const auto& p : particles) {
-        countByType[p.type]++;
-        massSumByType[p.type] += p.mass;
-    }
-
     cout << "Количество частиц по типам:\n";
-    for (const auto& [type, cnt] : countByType) {
-        cout << "  Тип " << typeColored(type) << ": " << cnt << '\n';
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        if (countByType[type] == 0) continue;
+        cout << "  Тип " << typeColored(type) << ": " << countByType[type] << '\n';
     }
 
     // --- Средняя масса по типам и в целом ---
     cout << "Средняя масса по типам:\n";
     double totalMass = 0.0;
-    for (const auto& [type, cnt] : countByType) {
-        double avgMass = massSumByType[type] / cnt;
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        if (countByType[type] == 0) continue;
+        double avgMass = massSumByType[type] / countByType[type];
         cout << "  Тип " << typeColored(type) << ": " << avgMass << '\n';
         totalMass += massSumByType[type];
     }
@@ -129,6 +190,49 @@ void Statistics::printSummary(const std::vector<Particle>& particles) {
     cout << "Количество резких ускорений: " << speedJumps << '\n';
     cout << "Всего случайных событий: " << totalRandomEvents << '\n';
     cout << "Частиц, переживших ≥1 случайное событие: " << particlesWithEvents << '\n';
+    cout << "Спящих частиц на последнем шаге (пропущены при расчёте): " << dormantParticles << '\n';
+}
+
+// Скорость и импульс по типам — тоже из агрегатов
+void Statistics::printKinematicsByType() const {
+    using namespace std;
+    cout << "Средняя скорость по типам:\n";
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        if (countByType[type] == 0) continue;
+        cout << "  Тип " << typeColored(type) << ": " << speedSumByType[type] / countByType[type] << '\n';
+    }
+    cout << "Суммарный импульс по типам:\n";
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        if (countByType[type] == 0) continue;
+        cout << "  Тип " << typeColored(type) << ": (" << momentumXByType[type]
+             << ", " << momentumYByType[type] << ")\n";
+    }
+}
+
+void Statistics::printStepTotals(size_t count) const {
+    using namespace std;
+    cout << "Число шагов симуляции: " << simulationSteps << '\n';
+    double avgParticlesPerFrame = simulationSteps ? 
+        (double)totalParticleCount / simulationSteps : count;
+    cout << "Среднее количество частиц на кадр: " << avgParticlesPerFrame << '\n';
+}
+
+// Основная функция — печать всей статистики симуляции
+void Statistics::printSummary(const std::vector<Particle>& particles) {
+    using namespace std;
+
+    size_t count = particles.size();
+    if (count == 0) {
+        cout << "Нет частиц для статистики.\n";
+        return;
+    }
+    // Агрегаты ведёт симуляция; если вызывающий их не вёл (или не пересчитал после создания
+    // частиц), сводка по типам не должна молча показывать нули
+    if (!aggregatesMatch(count)) recount(particles);
+
+    cout << "\n--- Итоговая статистика симуляции ---\n";
+
+    printTypeTotals(count);
 
     // --- Геометрия: дисперсия, расстояния ---
     vector<double> xs, ys;
@@ -195,22 +299,15 @@ void Statistics::printSummary(const std::vector<Particle>& particles) {
     // --- Скорости частиц ---
     vector<double> speeds;
     speeds.reserve(count);
-    map<int, vector<double>> speedsByType;
 
     for (const auto& p : particles) {
-        double sp = std::sqrt(p.vx * p.vx + p.vy * p.vy);
-        speeds.push_back(sp);
-        speedsByType[p.type].push_back(sp);
+        speeds.push_back(std::sqrt(p.vx * p.vx + p.vy * p.vy));
     }
 
     double avgSpeed = std::accumulate(speeds.begin(), speeds.end(), 0.0) / count;
 
     cout << "Средняя скорость всех частиц: " << avgSpeed << '\n';
-    cout << "Средняя скорость по типам:\n";
-    for (const auto& [type, spVec] : speedsByType) {
-        double sumSp = std::accumulate(spVec.begin(), spVec.end(), 0.0);
-        cout << "  Тип " << typeColored(type) << ": " << sumSp / spVec.size() << '\n';
-    }
+    printKinematicsByType();
 
     // --- Топ 3 по скорости и массе ---
     vector<std::pair<double, size_t>> speedIndex, massIndex;
@@ -243,11 +340,7 @@ void Statistics::printSummary(const std::vector<Particle>& particles) {
              << " Тип: " << typeColored(particles[idx].type) << '\n';
     }
 
-    // --- Общая статистика ---
-    cout << "Число шагов симуляции: " << simulationSteps << '\n';
-    double avgParticlesPerFrame = simulationSteps ? 
-        (double)totalParticleCount / simulationSteps : count;
-    cout << "Среднее количество частиц на кадр: " << avgParticlesPerFrame << '\n';
+    printStepTotals(count);
 
     // --- Сближения ---
     int closePairs = 0;
@@ -273,8 +366,35 @@ void Statistics::printSummary(const std::vector<Particle>& particles) {
     cout << "--- Конец статистики ---\n\n";
 }
 
+// Сводка только по агрегатам и счётчикам — O(TYPE_COUNT), без вектора частиц.
+// Для прогонов, где частицы не собираются в одном месте (MPI, компактное хранение);
+// агрегаты по типам к этому моменту должны быть сведены вызывающим
+void Statistics::printTotals(size_t count) const {
+    using namespace std;
+    if (count == 0) {
+        cout << "Нет частиц для статистики.\n";
+        return;
+    }
+
+    cout << "\n--- Итоговая статистика симуляции ---\n";
+    printTypeTotals(count);
+
+    double speedSum = std::accumulate(speedSumByType.begin(), speedSumByType.end(), 0.0);
+    cout << fixed << setprecision(3);
+    cout << "Средняя скорость всех частиц: " << speedSum / count << '\n';
+    printKinematicsByType();
+    printStepTotals(count);
+    cout << "--- Конец статистики ---\n\n";
+}
+
 // Сохраняет краткую статистику в CSV-файл
 void Statistics::saveToCSV(const std::vector<Particle>& particles, const char* filename) {
+    if (!aggregatesMatch(particles.size())) recount(particles);
+    saveTotalsToCSV(filename);
+}
+
+// То же по уже сведённым агрегатам — без вектора частиц
+void Statistics::saveTotalsToCSV(const char* filename) const {
     std::ofstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Ошибка открытия файла для записи статистики: " << filename << '\n';
@@ -283,18 +403,9 @@ void Statistics::saveToCSV(const std::vector<Particle>& particles, const char* f
 
     file << "Тип,Количество,Средняя масса,Средняя скорость\n";
 
-    std::map<int, int> countByType;
-    std::map<int, double> massSumByType;
-    std::map<int, double> speedSumByType;
-
-    for (const auto& p : particles) {
-        countByType[p.type]++;
-        massSumByType[p.type] += p.mass;
-        double sp = std::sqrt(p.vx * p.vx + p.vy * p.vy);
-        speedSumByType[p.type] += sp;
-    }
-
-    for (const auto& [type, cnt] : countByType) {
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        int cnt = countByType[type];
+        if (cnt == 0) continue;
         double avgMass = massSumByType[type] / cnt;
         double avgSpeed = speedSumByType[type] / cnt;
         file << type << "," << cnt << "," << avgMass << "," << avgSpeed << "\n";
@@ -312,3 +423,31 @@ void Statistics::saveToCSV(const std::vector<Particle>& particles, const char* f
     file << "Частиц с событиями," << particlesWithEvents << "\n";
     file << "Шагов симуляции," << simulationSteps << "\n";
 }
+
+// Заголовок сводки одного прогона: итоги по типам и счётчики событий
+void Statistics::writeSummaryHeader(std::ostream& out) {
+    out << "Частиц в конце";
+    for (int t = 0; t < TYPE_COUNT; ++t)
+        out << ",Тип " << t << " количество,Тип " << t << " средняя масса,Тип " << t << " средняя скорость";
+    out << ",Удалённых частиц,Размножений,Смен типов,Телепортаций,Спящих частиц,Смен массы"
+        << ",Резких ускорений,Всего случайных событий,Частиц с событиями,Шагов симуляции";
+}
+
+// Сводка одного прогона в формате writeSummaryHeader
+void Statistics::writeSummaryRow(std::ostream& out, const std::vector<Particle>& particles) const {
+    if (!aggregatesMatch(particles.size())) {
+        Statistics recounted = *this;
+        recounted.recount(particles);
+        recounted.writeSummaryRow(out, particles);
+        return;
+    }
+    out << particles.size();
+    for (int t = 0; t < TYPE_COUNT; ++t) {
+        int cnt = countByType[t];
+        out << "," << cnt << "," << (cnt ? massSumByType[t] / cnt : 0.0)
+            << "," << (cnt ? speedSumByType[t] / cnt : 0.0);
+    }
+    out << "," << removedParticles << "," << reproductions << "," << typeChanges << "," << teleports
+        << "," << sleepingParticles << "," << massChanges << "," << speedJumps
+        << "," << totalRandomEvents << "," << particlesWithEvents << "," << simulationSteps;
+}
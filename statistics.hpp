@@ -2,7 +2,10 @@
 #define STATISTICS_HPP
 
 #include <vector>
+#include <array>
+#include <iosfwd>
 #include "particle.hpp"
+#include "config.hpp"
 #include <cstddef>
 
 struct Statistics {
@@ -15,6 +18,7 @@ struct Statistics {
     int speedJumps = 0; // Счётчик резких скачков скорости
     int totalRandomEvents = 0; // Общее количество случайных событий, произошедших в симуляции
     int particlesWithEvents = 0; // Количество частиц, с которыми хотя бы один раз произошло случайное событие
+    int dormantParticles = 0; // Сколько спящих частиц было пропущено на последнем шаге (см. Activity)
 
     size_t simulationSteps = 0; // Общее количество шагов симуляции (итераций основного цикла)
     size_t totalParticleCount = 0; // Последнее известное количество частиц (используется при выводе итогов)
@@ -25,6 +29,20 @@ struct Statistics {
     // Булевый вектор по числу частиц — для отслеживания, была ли хотя бы раз с данной частицей случайность
     std::vector<bool> hadRandomEvent;
 
+    // Агрегаты по типам. Количество и масса обновляются при событиях (addParticle, removeParticle,
+    // changeType, changeMass), импульс и сумма скоростей — заново на каждом шаге интегрирования,
+    // так что сводки по типам стоят O(TYPE_COUNT), а не O(N)
+    std::array<int, TYPE_COUNT> countByType{}; // Количество частиц каждого типа
+    std::array<double, TYPE_COUNT> massSumByType{}; // Суммарная масса
+    std::array<double, TYPE_COUNT> momentumXByType{}; // Суммарный импульс по X
+    std::array<double, TYPE_COUNT> momentumYByType{}; // Суммарный импульс по Y
+    std::array<double, TYPE_COUNT> speedSumByType{}; // Сумма модулей скоростей
+
+    // Накопители импульса и скоростей текущего шага (см. beginKinematics)
+    std::array<double, TYPE_COUNT> stepMomentumX{};
+    std::array<double, TYPE_COUNT> stepMomentumY{};
+    std::array<double, TYPE_COUNT> stepSpeedSum{};
+
     void reset(size_t particleCount); // Сброс всех статистических данных
     void recordRandomEvent(size_t particleIndex); // Фиксация того, что с конкретной частицей (по индексу) произошло случайное событие
     void incrementEventCount(int eventType); // Универсальный метод для увеличения счётчиков по типу события
@@ -32,8 +50,32 @@ struct Statistics {
     void incrementStep(); // Увеличение количества шагов симуляции
     void updateParticleCount(size_t count); // Обновление общего количества частиц(если меняется)
 
+    void recount(const std::vector<Particle>& particles); // Полный пересчёт агрегатов по типам (после создания частиц)
+    // Пересчёт по частям, когда частицы лежат не в одном векторе: beginRecount, recountParticle для каждой, endRecount
+    void beginRecount();
+    void recountParticle(const Particle& p);
+    void endRecount();
+    bool aggregatesMatch(size_t particleCount) const; // Сходится ли сумма countByType с числом частиц
+    void addParticle(const Particle& p); // Частица появилась (размножение)
+    void removeParticle(const Particle& p); // Частица удалена
+    void changeType(const Particle& p, int oldType); // У частицы сменился тип (p — уже с новым типом)
+    void changeMass(const Particle& p, float oldMass); // У частицы сменилась масса (p — уже с новой массой)
+    void beginKinematics(); // Начало шага интегрирования: обнуление накопителей импульса и скоростей
+    void addKinematics(const Particle& p); // Учёт скорости частицы после её интегрирования
+    void endKinematics(); // Конец шага: накопленные значения становятся текущими
+
     void printSummary(const std::vector<Particle>& particles); // Печать краткой сводной статистики симуляции в консоль
+    void printTotals(size_t count) const; // Та же сводка без геометрии — только агрегаты и счётчики (частицы не нужны)
     void saveToCSV(const std::vector<Particle>& particles, const char* filename); // Сохранение данных о симуляции и частицах в файл .csv
+    void saveTotalsToCSV(const char* filename) const; // То же по агрегатам, когда вектора частиц нет (пара к printTotals)
+
+    // Части сводки, общие для printSummary и printTotals
+    void printTypeTotals(size_t count) const;
+    void printKinematicsByType() const;
+    void printStepTotals(size_t count) const;
+
+    static void writeSummaryHeader(std::ostream& out); // Заголовок для writeSummaryRow (столбцы через запятую, без перевода строки)
+    void writeSummaryRow(std::ostream& out, const std::vector<Particle>& particles) const; // Сводка прогона одной строкой CSV (без перевода строки)
 }; 
 
 #endif // STATISTICS_HPP
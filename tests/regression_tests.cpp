@@ -0,0 +1,738 @@
+// Регрессионные тесты движков: всё сравнивается с эталонным циклом simulate() / update_group()
+// на фиксированных seed. Режимы, обещающие побитовое совпадение (Activity без порогов, ансамбль,
+// разбиение на полосы при любом числе полос и потоков, инициализатор при любом числе потоков),
+// проверяются с допуском --ulps (по умолчанию 0); приближённые (полосы против simulate() —
+// по медиане, компактное хранение) — с абсолютным допуском по координатам и относительным по Statistics;
+// Activity с порогами по умолчанию и полосы со случайными событиями — по счётчикам и средним Statistics.
+// Прогон по MPI-процессам (ParticleSimDomain --verify) регистрируется в CMake отдельно, если найден MPI.
+//
+// Запуск: ParticleSimTests [группа ...] [--ulps N] [--position-tolerance X] [--stats-tolerance X]
+//   группы: reference activity ensemble domain compact initializer (без аргументов — все)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "compact.hpp"
+#include "config.hpp"
+#include "domain.hpp"
+#include "ensemble.hpp"
+#include "group.hpp"
+#include "initializer.hpp"
+#include "simulation.hpp"
+#include "statistics.hpp"
+
+// Допуски сравнения
+struct Tolerances {
+    int ulps = 0;                   // для побитово воспроизводимых режимов
+    float position = 0.05f;         // координаты и скорости приближённых режимов на коротком горизонте
+    double stats = 0.2;             // относительное отклонение средних по Statistics
+};
+
+static Tolerances tolerance;
+static int failures = 0;
+
+// Поле и число частиц подобраны так, чтобы все группы вместе укладывались в несколько секунд без оптимизации
+static const int WIDTH = 96;
+static const int HEIGHT = 32;
+
+static bool check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "  ОШИБКА: " << what << '\n';
+        failures++;
+    }
+    return ok;
+}
+
+// --- Сравнение чисел ---
+
+// Расстояние между числами в ULP (количество представимых float между ними)
+static int64_t ulpDistance(float a, float b) {
+    if (a == b) return 0;
+    if (std::isnan(a) || std::isnan(b)) return INT64_MAX;
+    int32_t ia, ib;
+    std::memcpy(&ia, &a, sizeof(a));
+    std::memcpy(&ib, &b, sizeof(b));
+    // Отрицательные числа переводятся в порядок, монотонный вместе с float
+    int64_t la = ia < 0 ? int64_t(INT32_MIN) - ia : ia;
+    int64_t lb = ib < 0 ? int64_t(INT32_MIN) - ib : ib;
+    return la > lb ? la - lb : lb - la;
+}
+
+static bool nearlyEqual(double a, double b, double relative) {
+    return std::fabs(a - b) <= relative * std::max({ std::fabs(a), std::fabs(b), 1e-12 });
+}
+
+// Разность координат по тору
+static float torusDelta(float a, float b, float size) {
+    float d = std::fabs(a - b);
+    return std::min(d, size - d);
+}
+
+// Частицы совпадают поле в поле (x, y, vx, vy, mass — в пределах ulps)
+static bool sameParticles(const std::vector<Particle>& a, const std::vector<Particle>& b, int ulps, const std::string& context) {
+    if (!check(a.size() == b.size(), context + ": разное число частиц (" + std::to_string(a.size()) + " и " +
+                                     std::to_string(b.size()) + ")"))
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const Particle& p = a[i];
+        const Particle& q = b[i];
+        bool ok = p.id == q.id && p.type == q.type && p.highlightTicks == q.highlightTicks
+                  && ulpDistance(p.x, q.x) <= ulps && ulpDistance(p.y, q.y) <= ulps
+                  && ulpDistance(p.vx, q.vx) <= ulps && ulpDistance(p.vy, q.vy) <= ulps
+                  && ulpDistance(p.mass, q.mass) <= ulps;
+        if (!ok) {
+            std::ostringstream msg;
+            msg << context << ": частица #" << i << " (id " << p.id << " / " << q.id << ") отличается: x "
+                << p.x << " / " << q.x << ", y " << p.y << " / " << q.y << ", vx " << p.vx << " / " << q.vx
+                << ", vy " << p.vy << " / " << q.vy;
+            return check(false, msg.str());
+        }
+    }
+    return true;
+}
+
+// Наибольшее расхождение координат и скоростей у частиц с одинаковыми индексами
+static float maxDeviation(const std::vector<Particle>& a, const std::vector<Particle>& b) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        worst = std::max({ worst, torusDelta(a[i].x, b[i].x, WIDTH), torusDelta(a[i].y, b[i].y, HEIGHT),
+                           std::fabs(a[i].vx - b[i].vx), std::fabs(a[i].vy - b[i].vy) });
+    }
+    return worst;
+}
+
+// Медиана расхождения по частицам — не чувствительна к отдельным тесным парам
+static float medianDeviation(const std::vector<Particle>& a, const std::vector<Particle>& b) {
+    std::vector<float> deviations;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i)
+        deviations.push_back(std::max(torusDelta(a[i].x, b[i].x, WIDTH), torusDelta(a[i].y, b[i].y, HEIGHT)));
+    if (deviations.empty()) return 0.0f;
+    std::nth_element(deviations.begin(), deviations.begin() + deviations.size() / 2, deviations.end());
+    return deviations[deviations.size() / 2];
+}
+
+// Среднее по частицам смещение (по тору) между двумя состояниями с одинаковым порядком частиц
+static double meanDisplacement(const std::vector<Particle>& a, const std::vector<Particle>& b, int width, int height) {
+    double sum = 0.0;
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i) {
+        float dx = torusDelta(a[i].x, b[i].x, float(width));
+        float dy = torusDelta(a[i].y, b[i].y, float(height));
+        sum += std::sqrt(dx * dx + dy * dy);
+    }
+    return n ? sum / n : 0.0;
+}
+
+// Счётчики событий Statistics совпадают
+static bool sameCounters(const Statistics& a, const Statistics& b, const std::string& context) {
+    bool ok = a.removedParticles == b.removedParticles && a.reproductions == b.reproductions
+              && a.typeChanges == b.typeChanges && a.teleports == b.teleports
+              && a.sleepingParticles == b.sleepingParticles && a.massChanges == b.massChanges
+              && a.speedJumps == b.speedJumps && a.totalRandomEvents == b.totalRandomEvents
+              && a.particlesWithEvents == b.particlesWithEvents && a.simulationSteps == b.simulationSteps
+              && a.totalParticleCount == b.totalParticleCount;
+    return check(ok, context + ": счётчики событий Statistics отличаются");
+}
+
+// Агрегаты по типам Statistics совпадают (relative = 0 — побитово)
+static bool sameAggregates(const Statistics& a, const Statistics& b, double relative, const std::string& context) {
+    bool ok = a.countByType == b.countByType;
+    for (int t = 0; t < TYPE_COUNT; ++t) {
+        ok = ok && nearlyEqual(a.massSumByType[t], b.massSumByType[t], relative)
+                && nearlyEqual(a.momentumXByType[t], b.momentumXByType[t], relative)
+                && nearlyEqual(a.momentumYByType[t], b.momentumYByType[t], relative)
+                && nearlyEqual(a.speedSumByType[t], b.speedSumByType[t], relative);
+    }
+    return check(ok, context + ": агрегаты Statistics по типам отличаются");
+}
+
+// Сумма скоростей всех частиц
+static double totalSpeed(const Statistics& stats) {
+    double sum = 0;
+    for (int t = 0; t < TYPE_COUNT; ++t) sum += stats.speedSumByType[t];
+    return sum;
+}
+
+// Число событий двух независимых прогонов согласуется со случайным разбросом: |a - b| <= 4 sigma
+static bool similarCount(long long a, long long b, const std::string& what, const std::string& context) {
+    double limit = 4.0 * std::sqrt(static_cast<double>(a + b)) + 3.0;
+    return check(std::llabs(a - b) <= limit,
+                 context + ": " + what + " " + std::to_string(a) + " против " + std::to_string(b));
+}
+
+// --- Сценарии ---
+
+struct Scenario {
+    int preset;           // 1-4 — simulate() с матрицей пресета, 5 — update_group()
+    bool events;
+    unsigned seed;
+    int count;
+    int steps;
+
+    std::string name() const {
+        return "пресет " + std::to_string(preset) + (events ? ", события" : ", без событий") + ", seed " + std::to_string(seed);
+    }
+};
+
+// Пресеты 1-5 с событиями и без (у update_group() случайных событий нет)
+static std::vector<Scenario> scenarios(int count, int steps) {
+    std::vector<Scenario> list;
+    for (int preset = 1; preset <= 5; ++preset)
+        for (bool events : { false, true })
+            if (preset != 5 || !events)
+                list.push_back({ preset, events, 100u + preset * 2 + events, count, steps });
+    return list;
+}
+
+static void initScenario(const Scenario& s, std::vector<Particle>& particles, Statistics& stats) {
+    if (s.preset == 5) init_group(particles, s.count, WIDTH, HEIGHT, s.seed);
+    else reset_particles(particles, s.count, WIDTH, HEIGHT, s.seed);
+    stats.reset(particles.size());
+    stats.recount(particles);
+}
+
+// Эталонный шаг — то же, что делает основной цикл main()
+static void referenceStep(const Scenario& s, std::vector<Particle>& particles, Statistics& stats,
+                          std::mt19937& rng, Activity* activity = nullptr) {
+    if (s.preset == 5) update_group(particles, WIDTH, HEIGHT, stats);
+    else simulate(particles, WIDTH, HEIGHT, s.events, stats, getInteractionMatrix(s.preset), rng, activity);
+    stats.incrementStep();
+    stats.updateParticleCount(particles.size());
+}
+
+// --- Группы тестов ---
+
+// Эталон воспроизводим и согласован сам с собой
+static void testReference() {
+    for (const auto& s : scenarios(120, 60)) {
+        std::vector<Particle> a, b;
+        Statistics statsA, statsB;
+        initScenario(s, a, statsA);
+        initScenario(s, b, statsB);
+        std::mt19937 rngA(s.seed), rngB(s.seed);
+
+        for (int step = 1; step <= s.steps; ++step) {
+            referenceStep(s, a, statsA, rngA);
+            referenceStep(s, b, statsB, rngB);
+            std::string context = s.name() + ", шаг " + std::to_string(step);
+            if (!sameParticles(a, b, tolerance.ulps, context + ", повторный прогон")) break;
+            if (!sameCounters(statsA, statsB, context)) break;
+
+            // Агрегаты, которые ведутся по ходу шага, совпадают с полным пересчётом
+            Statistics recounted = statsA;
+            recounted.recount(a);
+            if (!sameAggregates(statsA, recounted, 1e-9, context + ", пересчёт агрегатов")) break;
+
+            bool inside = std::all_of(a.begin(), a.end(), [](const Particle& p) {
+                return p.x >= 0 && p.x <= WIDTH && p.y >= 0 && p.y <= HEIGHT;
+            });
+            if (!check(inside, context + ": частица за пределами поля")) break;
+        }
+    }
+
+    // Другой seed даёт другой результат — иначе сравнения выше ничего не проверяют
+    Scenario s = scenarios(120, 20).front();
+    std::vector<Particle> a, b;
+    Statistics statsA, statsB;
+    initScenario(s, a, statsA);
+    s.seed++;
+    initScenario(s, b, statsB);
+    check(maxDeviation(a, b) > 0.0f, "разные seed дают одинаковое начальное состояние");
+}
+
+// Activity с отключёнными порогами никого не усыпляет и побитово совпадает с simulate(),
+// с порогами по умолчанию — совпадает по событиям и близка по средней скорости
+static void testActivity() {
+    for (const auto& s : scenarios(120, 60)) {
+        // Событие "усыпление" (6) усыпляет частицу независимо от порогов, а у пресета 5 нет Activity
+        if (s.events || s.preset == 5) continue;
+        std::vector<Particle> reference, active;
+        Statistics statsRef, statsAct;
+        initScenario(s, reference, statsRef);
+        initScenario(s, active, statsAct);
+        std::mt19937 rngRef(s.seed), rngAct(s.seed);
+
+        Activity activity;
+        activity.enabled = true;
+        activity.speedThreshold = 0.0f;
+        activity.accelThreshold = 0.0f;
+
+        for (int step = 1; step <= s.steps; ++step) {
+            referenceStep(s, reference, statsRef, rngRef);
+            referenceStep(s, active, statsAct, rngAct, &activity);
+            std::string context = s.name() + ", шаг " + std::to_string(step) + ", Activity";
+            if (!sameParticles(reference, active, tolerance.ulps, context)) break;
+            if (!check(statsAct.dormantParticles == 0, context + ": есть спящие частицы при нулевых порогах")) break;
+            if (!sameAggregates(statsRef, statsAct, 0.0, context)) break;
+        }
+    }
+
+    // Пороги по умолчанию: спящие частицы пропускают шаги, поэтому траектории расходятся,
+    // но события от координат не зависят (счётчики и число частиц по типам совпадают точно),
+    // а средняя скорость за прогон остаётся близкой к эталону
+    long long dormantTotal = 0;
+    for (const auto& s : scenarios(120, 200)) {
+        if (s.preset == 5) continue;
+        std::vector<Particle> reference, active;
+        Statistics statsRef, statsAct;
+        initScenario(s, reference, statsRef);
+        initScenario(s, active, statsAct);
+        std::mt19937 rngRef(s.seed), rngAct(s.seed);
+
+        Activity activity;
+        activity.enabled = true;
+
+        double speedRef = 0, speedAct = 0;
+        std::string context = s.name() + ", Activity с порогами по умолчанию";
+        for (int step = 1; step <= s.steps; ++step) {
+            referenceStep(s, reference, statsRef, rngRef);
+            referenceStep(s, active, statsAct, rngAct, &activity);
+            dormantTotal += statsAct.dormantParticles;
+            speedRef += totalSpeed(statsRef);
+            speedAct += totalSpeed(statsAct);
+            std::string stepContext = context + ", шаг " + std::to_string(step);
+            if (!sameCounters(statsRef, statsAct, stepContext)) break;
+            if (!check(statsRef.countByType == statsAct.countByType, stepContext + ": число частиц по типам отличается")) break;
+        }
+        check(nearlyEqual(speedRef, speedAct, tolerance.stats),
+              context + ": сумма скоростей за прогон " + std::to_string(speedRef) + " против " + std::to_string(speedAct));
+    }
+    // Иначе сравнение выше ничего не проверяет
+    check(dormantTotal > 0, "Activity с порогами по умолчанию никого не усыпила");
+}
+
+// Прогон ансамбля совпадает с прямым прогоном эталона, а весь ансамбль — при любом числе потоков
+static void testEnsemble() {
+    SweepSpec spec;
+    spec.width = WIDTH;
+    spec.height = HEIGHT;
+    spec.steps = 40;
+    spec.enableRandomEvents = true;
+    for (int preset = 1; preset <= 5; ++preset) {
+        SweepMatrix m;
+        m.label = "preset" + std::to_string(preset);
+        m.preset = preset;
+        if (preset != 5) m.matrix = getInteractionMatrix(preset);
+        spec.matrices.push_back(m);
+    }
+    spec.particleCounts = { 60, 90 };
+    spec.seeds = { 1, 2 };
+
+    for (const auto& run : expandSweep(spec)) {
+        Scenario s{ run.matrix->preset, spec.enableRandomEvents, run.seed, run.particleCount, spec.steps };
+        std::vector<Particle> particles;
+        Statistics stats;
+        initScenario(s, particles, stats);
+        std::seed_seq eventSeed{ run.seed, 1u };
+        std::mt19937 rng(eventSeed);
+        for (int step = 0; step < s.steps; ++step)
+            referenceStep(s, particles, stats, rng);
+
+        std::ostringstream direct;
+        stats.writeSummaryRow(direct, particles);
+        std::string member = runEnsembleMember(spec, run);
+        const std::string& expected = direct.str();
+        bool ok = member.size() >= expected.size()
+                  && member.compare(member.size() - expected.size(), expected.size(), expected) == 0;
+        check(ok, "ансамбль, " + run.matrix->label + ", " + std::to_string(run.particleCount) + " частиц, seed " +
+                  std::to_string(run.seed) + ": сводка отличается от прямого прогона");
+    }
+
+    std::string files[2] = { "ensemble_test_1.csv", "ensemble_test_3.csv" };
+    int threads[2] = { 1, 3 };
+    std::string contents[2];
+    for (int k = 0; k < 2; ++k) {
+        check(runEnsemble(spec, files[k].c_str(), threads[k]), "ансамбль не записал " + files[k]);
+        std::ifstream in(files[k]);
+        std::ostringstream text;
+        text << in.rdbuf();
+        contents[k] = text.str();
+        std::remove(files[k].c_str());
+    }
+    check(!contents[0].empty() && contents[0] == contents[1], "ансамбль: результаты с 1 и 3 потоками отличаются");
+
+    // Описание перебора: хвост строки не отбрасывается молча
+    const char* specFile = "ensemble_test_spec.txt";
+    struct SpecCase { const char* text; bool valid; };
+    const SpecCase cases[] = {
+        { "particles 100 200\npreset 1\nseeds 1-3 7\n", true },
+        { "particles 100 abc\npreset 1\n", false },
+        { "particles\npreset 1\n", false },
+        { "particles 100\npreset 1 x\n", false },
+        { "particles 100\npreset 1\nseeds 1-4x\n", false },
+        { "particles 100\npreset 1\nsize 10 20 30\n", false },
+        { "particles 100\nmatrix m 1 1 1 1 1 1 1 1 1 1\n", false },
+    };
+    for (const auto& c : cases) {
+        std::ofstream(specFile) << c.text;
+        SweepSpec parsed;
+        check(loadSweepSpec(specFile, parsed) == c.valid,
+              std::string("описание перебора ") + (c.valid ? "отвергнуто" : "принято") + ": " + c.text);
+    }
+    std::remove(specFile);
+
+    // Имя матрицы с запятой и кавычкой не ломает столбцы CSV
+    SweepSpec labelled = spec;
+    labelled.steps = 1;
+    labelled.matrices = { SweepMatrix{ "a,\"b\"", 1, getInteractionMatrix(1) } };
+    labelled.particleCounts = { 10 };
+    labelled.seeds = { 1 };
+    std::string row = runEnsembleMember(labelled, expandSweep(labelled)[0]);
+    check(row.rfind("0,\"a,\"\"b\"\"\",1,10,1,", 0) == 0, "ансамбль: имя матрицы не экранировано в CSV: " + row);
+}
+
+// Полосы со случайными событиями против simulate(): генераторы событий у них разные
+// (хеш от (seed, шаг, id) против mt19937), поэтому прогоны — две независимые реализации.
+// Число событий каждого вида должно совпадать в пределах случайного разброса, общее — в пределах
+// --stats-tolerance. Среднюю скорость не сравниваем: скачки скорости в разные моменты меняют её вдвое
+static void compareDomainEvents(Scenario s) {
+    s.steps = 200;
+    std::vector<Particle> particles;
+    Statistics stats;
+    initScenario(s, particles, stats);
+
+    DomainConfig config;
+    config.seed = s.seed;
+    config.enableRandomEvents = true;
+    config.matrix = getInteractionMatrix(s.preset);
+    config.slabs = 3;
+    config.threads = 2;
+    DomainSim domain(WIDTH, HEIGHT, config);
+    domain.scatter(particles);
+    Statistics domainStats;
+    domainStats.reset(particles.size());
+
+    std::mt19937 rng(s.seed);
+    for (int step = 1; step <= s.steps; ++step) {
+        referenceStep(s, particles, stats, rng);
+        domain.step(domainStats);
+    }
+
+    std::string context = s.name() + ", полосы с событиями против simulate()";
+    similarCount(stats.removedParticles, domainStats.removedParticles, "удалений", context);
+    similarCount(stats.reproductions, domainStats.reproductions, "размножений", context);
+    similarCount(stats.typeChanges, domainStats.typeChanges, "смен типа", context);
+    similarCount(stats.teleports, domainStats.teleports, "телепортаций", context);
+    similarCount(stats.sleepingParticles, domainStats.sleepingParticles, "усыплений", context);
+    similarCount(stats.massChanges, domainStats.massChanges, "смен массы", context);
+    similarCount(stats.speedJumps, domainStats.speedJumps, "скачков скорости", context);
+    similarCount(stats.particlesWithEvents, domainStats.particlesWithEvents, "частиц с событиями", context);
+    check(nearlyEqual(stats.totalRandomEvents, domainStats.totalRandomEvents, tolerance.stats),
+          context + ": всего событий " + std::to_string(stats.totalRandomEvents) + " против " +
+          std::to_string(domainStats.totalRandomEvents));
+
+    std::vector<Particle> gathered;
+    domain.gather(gathered);
+    similarCount(static_cast<long long>(particles.size()), static_cast<long long>(gathered.size()),
+                 "частиц в конце", context);
+}
+
+// Разбиение на полосы побитово одинаково при любом числе полос и потоков и близко к simulate()
+static void testDomain() {
+    for (const auto& s : scenarios(120, 30)) {
+        if (s.preset == 5) continue; // у update_group() стены, а не тор
+        for (float cutoff : { 0.0f, 12.0f }) {
+            std::vector<Particle> initial;
+            Statistics initStats;
+            initScenario(s, initial, initStats);
+
+            DomainConfig config;
+            config.seed = s.seed;
+            config.enableRandomEvents = s.events;
+            config.matrix = getInteractionMatrix(s.preset);
+            config.cutoff = cutoff;
+
+            DomainSim reference(WIDTH, HEIGHT, config);
+            reference.scatter(initial);
+            Statistics referenceStats;
+            referenceStats.reset(initial.size());
+
+            struct Variant { int slabs, threads; };
+            std::vector<Variant> variants = { { 2, 1 }, { 3, 2 }, { 5, 4 } };
+            std::vector<DomainSim> sims;
+            std::vector<Statistics> simStats(variants.size());
+            for (size_t v = 0; v < variants.size(); ++v) {
+                DomainConfig c = config;
+                c.slabs = variants[v].slabs;
+                c.threads = variants[v].threads;
+                sims.emplace_back(WIDTH, HEIGHT, c);
+                sims.back().scatter(initial);
+                simStats[v].reset(initial.size());
+            }
+
+            bool ok = true;
+            std::vector<Particle> expected, actual;
+            for (int step = 1; step <= s.steps && ok; ++step) {
+                reference.step(referenceStats);
+                reference.gather(expected);
+                for (size_t v = 0; v < sims.size() && ok; ++v) {
+                    sims[v].step(simStats[v]);
+                    sims[v].gather(actual);
+                    std::string context = s.name() + ", обрезка " + std::to_string(int(cutoff)) + ", " +
+                                          std::to_string(variants[v].slabs) + " полос / " +
+                                          std::to_string(variants[v].threads) + " потоков, шаг " + std::to_string(step);
+                    ok = sameParticles(expected, actual, tolerance.ulps, context) &&
+                         sameCounters(referenceStats, simStats[v], context);
+                }
+            }
+        }
+
+        // Полосы считают силы по снимку начала шага, а simulate() — по уже сдвинутым частицам:
+        // тесные пары расходятся сразу (и заметно меняют среднюю скорость), поэтому с эталоном
+        // сравнивается только медиана отклонения на первых шагах
+        if (s.events) {
+            compareDomainEvents(s);
+            continue;
+        }
+        std::vector<Particle> particles;
+        Statistics stats;
+        initScenario(s, particles, stats);
+        DomainConfig config;
+        config.matrix = getInteractionMatrix(s.preset);
+        DomainSim domain(WIDTH, HEIGHT, config);
+        domain.scatter(particles);
+        std::mt19937 rng(s.seed);
+        Statistics domainStats;
+        std::vector<Particle> gathered;
+        for (int step = 1; step <= 2; ++step) {
+            referenceStep(s, particles, stats, rng);
+            domain.step(domainStats);
+            domain.gather(gathered);
+            std::string context = s.name() + ", шаг " + std::to_string(step) + ", полосы против simulate()";
+            float deviation = medianDeviation(particles, gathered);
+            check(deviation <= tolerance.position, context + ": медиана отклонения " + std::to_string(deviation));
+        }
+    }
+}
+
+// Компактное хранение: события совпадают с simulate() точно, движение — с допуском
+static void testCompact() {
+    for (const auto& s : scenarios(120, 60)) {
+        if (s.preset == 5) continue; // simulate_compact() повторяет только simulate()
+        std::vector<Particle> reference;
+        Statistics statsRef;
+        initScenario(s, reference, statsRef);
+
+        // Эталон стартует с того же квантованного состояния
+        CompactParticles compact;
+        compact.encode(reference, WIDTH, HEIGHT);
+        compact.decode(reference);
+        statsRef.recount(reference);
+        Statistics statsCompact = statsRef;
+
+        std::mt19937 rngRef(s.seed), rngCompact(s.seed);
+        const InteractionMatrix matrix = getInteractionMatrix(s.preset);
+        double speedRef = 0.0, speedCompact = 0.0;
+        std::vector<Particle> decoded;
+
+        for (int step = 1; step <= s.steps; ++step) {
+            referenceStep(s, reference, statsRef, rngRef);
+            simulate_compact(compact, s.events, statsCompact, matrix, rngCompact);
+            statsCompact.incrementStep();
+            statsCompact.updateParticleCount(compact.size());
+            std::string context = s.name() + ", шаг " + std::to_string(step) + ", компактное хранение";
+
+            if (!sameCounters(statsRef, statsCompact, context)) break;
+            if (!check(statsRef.countByType == statsCompact.countByType, context + ": число частиц по типам отличается"))
+                break;
+            for (int t = 0; t < TYPE_COUNT; ++t) {
+                speedRef += statsRef.speedSumByType[t];
+                speedCompact += statsCompact.speedSumByType[t];
+            }
+
+            // Траектории хаотичны (тесные пары усиливают ошибку квантования уже на втором шаге),
+            // поэтому по частицам сравнивается только первый шаг
+            if (step == 1) {
+                compact.decode(decoded);
+                float deviation = maxDeviation(reference, decoded);
+                check(deviation <= tolerance.position, context + ": отклонение " + std::to_string(deviation));
+            }
+        }
+
+        for (int t = 0; t < TYPE_COUNT; ++t)
+            check(nearlyEqual(statsRef.massSumByType[t], statsCompact.massSumByType[t], 1e-3),
+                  s.name() + ": масса типа " + std::to_string(t) + " отличается в компактном хранении");
+        check(nearlyEqual(speedRef, speedCompact, tolerance.stats),
+              s.name() + ": сумма скоростей за шаг в компактном хранении " + std::to_string(speedCompact / s.steps) +
+              " против " + std::to_string(speedRef / s.steps));
+    }
+
+    // Большое поле: смещения за шаг много меньше доли поля, и квантование координат
+    // не должно их съедать (частицы не "замерзают"). Кластеры — чтобы частицы заметно
+    // взаимодействовали и на поле 4000x4000; компактное хранилище заполняется напрямую
+    for (int size : { 1000, 4000 }) {
+        for (int preset = 1; preset <= 4; ++preset) {
+            InitConfig config;
+            config.layout = Layout::Clustered;
+            config.seed = 300u + preset;
+            std::vector<Particle> reference, decoded, before;
+            init_particles(reference, 200, size, size, config);
+            CompactParticles compact, encoded;
+            init_particles(compact, 200, size, size, config);
+            encoded.encode(reference, size, size);
+            encoded.decode(before);
+            compact.decode(reference);
+            sameParticles(before, reference, 0, "компактное хранение, поле " + std::to_string(size) +
+                                                ": прямое заполнение отличается от упаковки вектора");
+            Statistics statsRef, statsCompact;
+            statsRef.reset(reference.size());
+            statsRef.recount(reference);
+            statsCompact = statsRef;
+            std::mt19937 rngRef(1), rngCompact(1);
+            const InteractionMatrix matrix = getInteractionMatrix(preset);
+
+            double moveRef = 0.0, moveCompact = 0.0, speedRef = 0.0, speedCompact = 0.0;
+            for (int step = 0; step < 40; ++step) {
+                before = reference;
+                simulate(reference, size, size, false, statsRef, matrix, rngRef);
+                moveRef += meanDisplacement(before, reference, size, size);
+
+                compact.decode(before);
+                simulate_compact(compact, false, statsCompact, matrix, rngCompact);
+                compact.decode(decoded);
+                moveCompact += meanDisplacement(before, decoded, size, size);
+                for (int t = 0; t < TYPE_COUNT; ++t) {
+                    speedRef += statsRef.speedSumByType[t];
+                    speedCompact += statsCompact.speedSumByType[t];
+                }
+            }
+            std::string context = "компактное хранение, поле " + std::to_string(size) + "x" + std::to_string(size) +
+                                  ", пресет " + std::to_string(preset);
+            check(nearlyEqual(moveRef, moveCompact, tolerance.stats),
+                  context + ": среднее смещение за шаг " + std::to_string(moveCompact / 40) + " против " +
+                  std::to_string(moveRef / 40));
+            check(nearlyEqual(speedRef, speedCompact, tolerance.stats),
+                  context + ": сумма скоростей за шаг " + std::to_string(speedCompact / 40) + " против " +
+                  std::to_string(speedRef / 40));
+        }
+    }
+}
+
+// Начальное состояние не зависит от числа потоков инициализации
+static void testInitializer() {
+    const int width = 200;
+    const int height = 100;
+    for (Layout layout : { Layout::Uniform, Layout::Clustered, Layout::Bands, Layout::PoissonDisk }) {
+        InitConfig config;
+        config.layout = layout;
+        config.seed = 42;
+        const int count = layout == Layout::PoissonDisk ? 6000 : 10000; // несколько блоков по 4096
+
+        std::vector<Particle> expected;
+        init_particles(expected, count, width, height, config);
+        std::string name = "расположение " + std::to_string(static_cast<int>(layout));
+
+        bool valid = static_cast<int>(expected.size()) == count;
+        for (int i = 0; i < static_cast<int>(expected.size()) && valid; ++i) {
+            const Particle& p = expected[i];
+            valid = p.id == i && p.x >= 0 && p.x < width && p.y >= 0 && p.y < height
+                    && p.type >= 0 && p.type < TYPE_COUNT && p.mass >= config.massMin && p.mass <= config.massMax;
+        }
+        check(valid, name + ": некорректные частицы");
+
+        for (int threads : { 2, 3, 8 }) {
+            config.threads = threads;
+            std::vector<Particle> actual(17); // непустой вектор должен быть полностью перезаписан
+            init_particles(actual, count, width, height, config);
+            sameParticles(expected, actual, tolerance.ulps, name + ", " + std::to_string(threads) + " потоков");
+        }
+
+        config.threads = 1;
+        config.seed = 43;
+        std::vector<Particle> other;
+        init_particles(other, count, width, height, config);
+        check(maxDeviation(expected, other) > 0.0f, name + ": разные seed дают одинаковое состояние");
+
+        // Подготовленное в фоне состояние совпадает с прямой инициализацией
+        config.seed = 42;
+        PrebuiltState prebuilt;
+        prebuilt.prepare([&](std::vector<Particle>& out) { return init_particles(out, count, width, height, config); });
+        std::vector<Particle> taken;
+        check(prebuilt.take(taken), name + ": PrebuiltState ничего не подготовил");
+        sameParticles(expected, taken, 0, name + ", PrebuiltState");
+
+        // Неудачная подготовка не подменяет текущее состояние
+        prebuilt.prepare([](std::vector<Particle>&) { return false; });
+        check(!prebuilt.take(taken), name + ": PrebuiltState не сообщил о неудачной подготовке");
+        sameParticles(expected, taken, 0, name + ", PrebuiltState после неудачной подготовки");
+    }
+
+    // Пуассоновский диск: если частицы помещаются, ближе minDistance они не стоят
+    InitConfig poisson;
+    poisson.layout = Layout::PoissonDisk;
+    poisson.seed = 7;
+    std::vector<Particle> particles;
+    check(init_particles(particles, 1500, 80, 40, poisson), "пуассоновский диск: 1500 частиц не построены");
+    float closest = 1e9f;
+    for (size_t i = 0; i < particles.size(); ++i) {
+        for (size_t j = i + 1; j < particles.size(); ++j) {
+            float dx = torusDelta(particles[i].x, particles[j].x, 80);
+            float dy = torusDelta(particles[i].y, particles[j].y, 40);
+            closest = std::min(closest, std::sqrt(dx * dx + dy * dy));
+        }
+    }
+    check(closest >= poisson.minDistance * 0.999f, "пуассоновский диск: частицы ближе minDistance (" +
+                                                   std::to_string(closest) + ")");
+
+    // Не помещаются даже на наименьшем расстоянии — ошибка сразу, без перебора радиусов,
+    // а прежние частицы остаются на месте (на этом держится перезапуск "r" в main)
+    std::vector<Particle> crowded = particles;
+    check(!init_particles(crowded, 1000000, 80, 40, poisson),
+          "пуассоновский диск: 10^6 частиц на поле 80x40 не отвергнуты");
+    sameParticles(particles, crowded, 0, "пуассоновский диск: частицы после отказа");
+    CompactParticles compactCrowded;
+    compactCrowded.encode(particles, 80, 40);
+    check(!init_particles(compactCrowded, 1000000, 80, 40, poisson) && compactCrowded.size() == particles.size(),
+          "пуассоновский диск: компактное хранилище изменено после отказа");
+}
+
+struct Group {
+    const char* name;
+    void (*run)();
+};
+
+static const Group GROUPS[] = {
+    { "reference", testReference },
+    { "activity", testActivity },
+    { "ensemble", testEnsemble },
+    { "domain", testDomain },
+    { "compact", testCompact },
+    { "initializer", testInitializer },
+};
+
+int main(int argc, char** argv) {
+    std::vector<const Group*> selected;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--ulps") && hasValue) tolerance.ulps = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--position-tolerance") && hasValue) tolerance.position = std::strtof(argv[++i], nullptr);
+        else if (!std::strcmp(argv[i], "--stats-tolerance") && hasValue) tolerance.stats = std::strtod(argv[++i], nullptr);
+        else {
+            auto it = std::find_if(std::begin(GROUPS), std::end(GROUPS),
+                                   [&](const Group& g) { return !std::strcmp(g.name, argv[i]); });
+            if (it == std::end(GROUPS)) {
+                std::cerr << "Неизвестная группа тестов или параметр: " << argv[i] << '\n';
+                return 2;
+            }
+            selected.push_back(&*it);
+        }
+    }
+    if (selected.empty())
+        for (const auto& g : GROUPS) selected.push_back(&g);
+
+    for (const Group* g : selected) {
+        int before = failures;
+        g->run();
+        std::cout << (failures == before ? "[ ok ] " : "[FAIL] ") << g->name << '\n';
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadCount) {
+    threadCount = std::max(1, threadCount);
+    for (int i = 0; i < threadCount; ++i)
+        queues.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < threadCount; ++i)
+        threads.emplace_back([this, i] { workerLoop(static_cast<size_t>(i)); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    Queue& q = *queues[nextQueue];
+    nextQueue = (nextQueue + 1) % queues.size();
+
+    unfinished++;
+    {
+        // Счётчик меняется под sleepMutex, чтобы засыпающий поток не пропустил задачу
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    allDone.wait(lock, [this] { return unfinished.load() == 0; });
+}
+
+// Своя очередь — с конца (недавние задачи, данные ещё в кэше)
+bool ThreadPool::popLocal(size_t index, std::function<void()>& task) {
+    Queue& q = *queues[index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+// Чужие очереди — с начала, обходя соседей по кругу
+bool ThreadPool::steal(size_t index, std::function<void()>& task) {
+    for (size_t k = 1; k < queues.size(); ++k) {
+        Queue& q = *queues[(index + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    while (true) {
+        std::function<void()> task;
+        if (popLocal(index, task) || steal(index, task)) {
+            queued--;
+            task();
+            if (--unfinished == 0) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом работы (work stealing): у каждого потока своя очередь,
+// задачи берутся с её конца, а опустевший поток забирает задачи из начала чужих очередей
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task); // добавить задачу (из одного потока; очереди заполняются по кругу)
+    void wait();                             // дождаться выполнения всех добавленных задач
+    int size() const { return static_cast<int>(threads.size()); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    size_t nextQueue = 0;                 // очередь для следующей задачи из submit()
+    std::atomic<size_t> queued{0};        // задач в очередях
+    std::atomic<size_t> unfinished{0};    // задач, ещё не завершённых
+    bool stopping = false;
+
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable; // появилась задача или пул останавливается
+    std::condition_variable allDone;       // все задачи завершены
+
+    bool popLocal(size_t index, std::function<void()>& task);
+    bool steal(size_t index, std::function<void()>& task);
+    void workerLoop(size_t index);
+};